@@ -0,0 +1,67 @@
+// Measures the multiplication kernels in `ntt.hpp` to tune the thresholds of `ntt_plan::convolution`.
+// Prints the time per product for balanced `n x n` products and lopsided `n x 64n` products.
+// Usage: benchmark_convolution [max_log_n = 12]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <string>
+#include <atcoder/modint>
+#include <kotone/ntt>
+
+using mint = atcoder::modint998244353;
+
+std::vector<mint> transform_once(const std::vector<mint> &a, const std::vector<mint> &b) {
+    int len = a.size() + b.size() - 1, n = std::bit_ceil(unsigned(len));
+    const kotone::ntt_plan<mint> &plan = kotone::shared_ntt_plan<mint>(n);
+    std::vector<mint> x(n), y(n);
+    std::copy(a.begin(), a.end(), x.begin());
+    std::copy(b.begin(), b.end(), y.begin());
+    plan.forward(x);
+    plan.forward(y);
+    plan.multiply(x, y);
+    plan.inverse(x);
+    x.resize(len);
+    return x;
+}
+
+// Returns the average time in microseconds of `f()` over enough repetitions to run for about 20 ms.
+template <typename F> double measure(F f) {
+    using clock = std::chrono::steady_clock;
+    int reps = 0;
+    auto start = clock::now();
+    double elapsed;
+    do {
+        f();
+        reps++;
+        elapsed = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+    } while (elapsed < 20000);
+    return elapsed / reps;
+}
+
+int main(int argc, char **argv) {
+    int max_log_n = argc > 1 ? std::stoi(argv[1]) : 12;
+    std::mt19937 rng(0);
+    auto random_fps = [&](int n) {
+        std::vector<mint> fps(n);
+        for (mint &c : fps) c = rng();
+        return fps;
+    };
+    std::cout << std::fixed << std::setprecision(2);
+    for (int ratio : {1, 64}) {
+        std::cout << "n x " << ratio << "n (us)\nn\tschool\tkara\tntt\tdispatch\n";
+        for (int log_n = 2; log_n <= max_log_n; log_n++) {
+            int n = 1 << log_n;
+            std::vector<mint> a = random_fps(n), b = random_fps(n * ratio), c(n * (ratio + 1) - 1);
+            std::cout << n;
+            if (n <= 1024) std::cout << '\t' << measure([&] { kotone::schoolbook_convolution<mint>(a, b, c); });
+            else std::cout << "\t-";
+            std::cout << '\t' << measure([&] { kotone::karatsuba_convolution<mint>(a, b, c); });
+            std::cout << '\t' << measure([&] { transform_once(a, b); });
+            std::cout << '\t' << measure([&] { kotone::ntt_convolution(a, b); });
+            std::cout << std::endl;
+        }
+    }
+}
@@ -0,0 +1,89 @@
+// Compares the Newton iterations in `convolution_util` against straightforward versions
+// that call `atcoder::convolution` twice per step.
+// Usage: benchmark_convolution_util [max_log_n = 23]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <string>
+#include <atcoder/convolution>
+#include <kotone/convolution_util>
+
+using mint = atcoder::modint998244353;
+
+std::vector<mint> reference_inv(const std::vector<mint> &fps, int n) {
+    std::vector<mint> result{1 / fps[0]};
+    int len = static_cast<int>(fps.size());
+    for (int m = 1; m < n;) {
+        m = std::min(m * 2, n);
+        std::vector<mint> sub(fps.begin(), fps.begin() + std::min(m, len));
+        sub.resize(m);
+        std::vector<mint> prod = atcoder::convolution(result, sub);
+        prod.resize(m);
+        prod[0] = 2 - prod[0];
+        for (int i = 1; i < m; i++) prod[i] = -prod[i];
+        result = atcoder::convolution(result, prod);
+        result.resize(m);
+    }
+    return result;
+}
+
+std::vector<mint> reference_log(const std::vector<mint> &fps, int n) {
+    std::vector<mint> dfps = kotone::derivative(std::vector<mint>(fps.begin(), fps.begin() + std::min<int>(n, fps.size())));
+    std::vector<mint> prod = atcoder::convolution(dfps, reference_inv(fps, n - 1));
+    prod.resize(n - 1);
+    std::vector<mint> result = kotone::integral(prod);
+    result.resize(n);
+    return result;
+}
+
+std::vector<mint> reference_exp(const std::vector<mint> &fps, int n) {
+    std::vector<mint> result{1};
+    for (int m = 1; m < n;) {
+        m = std::min(m * 2, n);
+        std::vector<mint> log = reference_log(result, m);
+        for (int i = 0; i < m; i++) {
+            log[i] = -log[i];
+            if (i < static_cast<int>(fps.size())) log[i] += fps[i];
+        }
+        log[0] += 1;
+        result = atcoder::convolution(result, log);
+        result.resize(m);
+    }
+    return result;
+}
+
+template <typename F> double measure(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    int max_log_n = argc > 1 ? std::stoi(argv[1]) : 23;
+    std::mt19937 rng(0);
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "log_n\tinv_ref\tinv\tlog_ref\tlog\texp_ref\texp\t(ms)\n";
+    for (int log_n = 10; log_n <= max_log_n; log_n++) {
+        int n = 1 << log_n;
+        std::vector<mint> fps(n);
+        for (mint &c : fps) c = rng();
+        fps[0] = 1;
+        std::vector<mint> fps_exp = fps;
+        fps_exp[0] = 0;
+        std::vector<mint> a, b;
+        std::cout << log_n;
+        std::cout << '\t' << measure([&] { a = reference_inv(fps, n); });
+        std::cout << '\t' << measure([&] { b = kotone::inv_fps(fps, n); });
+        if (a != b) std::cout << "(mismatch)";
+        std::cout << '\t' << measure([&] { a = reference_log(fps, n); });
+        std::cout << '\t' << measure([&] { b = kotone::log_fps(fps, n); });
+        if (a != b) std::cout << "(mismatch)";
+        std::cout << '\t' << measure([&] { a = reference_exp(fps_exp, n); });
+        std::cout << '\t' << measure([&] { b = kotone::exp_fps(fps_exp, n); });
+        if (a != b) std::cout << "(mismatch)";
+        std::cout << std::endl;
+    }
+}
@@ -3,60 +3,263 @@
 
 #include <vector>
 #include <complex>
+#include <span>
 #include <cmath>
 #include <numbers>
 #include <bit>
+#include <algorithm>
 #include <concepts>
 #include <cassert>
+#include <kotone/internal_parallel>
 
 namespace kotone {
 
+// Multiplies two complex numbers without the NaN and infinity handling of `std::complex::operator*`.
+template <std::floating_point T> std::complex<T> fft_multiply(std::complex<T> a, std::complex<T> b) {
+    return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+// A reusable fast Fourier transform that owns its twiddle table and scratch buffer.
+// A plan of size `n` supports transforms of every power-of-two length up to `n`.
+// Forward transforms evaluate at the powers of `polar(1, 2 * pi / len)` and produce values in bit-reversed order,
+// which inverse transforms accept, so pointwise operations between the two need no permutation.
+template <std::floating_point T> struct fft_plan {
+  private:
+    int _size{};
+    std::vector<std::complex<T>> _roots;
+    std::vector<std::complex<T>> _buffer;
+
+    // The minimum length from which `forward` and `inverse` use threads when asked to.
+    static constexpr int _PARALLEL_THRESHOLD = 1 << 16;
+    // The number of elements that a group of columns in a parallel transform is sized to.
+    static constexpr int _CACHE_ELEMENTS = 1 << 14;
+
+    void _inverse_unscaled(std::span<std::complex<T>> fps) const {
+        int n = static_cast<int>(fps.size());
+        for (int len = 1; len < n; len *= 2) {
+            const std::complex<T> *w = _roots.data() + len;
+            for (int i = 0; i < n; i += len * 2) {
+                std::complex<T> *a = fps.data() + i, *b = a + len;
+                for (int j = 0; j < len; j++) {
+                    std::complex<T> u = a[j], v = fft_multiply(b[j], std::conj(w[j]));
+                    a[j] = u + v;
+                    b[j] = u - v;
+                }
+            }
+        }
+    }
+
+  public:
+    fft_plan() : fft_plan(1) {}
+
+    // Constructs a plan for transforms of length up to `size`.
+    // The table holds `roots[len + j] == polar(1, pi * j / len)` for each power of two `len < size`,
+    // computed directly from `cos` and `sin` at the largest level to avoid accumulated error.
+    // Requires `size` to be a power of `2`.
+    fft_plan(int size) : _size(size), _roots(std::max(size, 2)) {
+        assert(std::has_single_bit(unsigned(size)));
+        _roots[1] = 1;
+        int top = size / 2;
+        for (int j = 0; j < top; j++) {
+            T arg = std::numbers::pi_v<T> * j / top;
+            _roots[top + j] = {std::cos(arg), std::sin(arg)};
+        }
+        for (int len = top / 2; len >= 1; len /= 2) {
+            for (int j = 0; j < len; j++) _roots[len + j] = _roots[(len + j) * 2];
+        }
+    }
+
+    // Returns the maximum transform length supported by the plan.
+    int size() const {
+        return _size;
+    }
+
+    // Transforms `fps` in place from natural order to bit-reversed order in decimation-in-frequency order.
+    // Requires the size of `fps` to be a power of `2` not greater than `size()`.
+    void forward(std::span<std::complex<T>> fps) const {
+        int n = static_cast<int>(fps.size());
+        assert(std::has_single_bit(unsigned(n)) && n <= _size);
+        for (int len = n / 2; len >= 1; len /= 2) {
+            const std::complex<T> *w = _roots.data() + len;
+            for (int i = 0; i < n; i += len * 2) {
+                std::complex<T> *a = fps.data() + i, *b = a + len;
+                for (int j = 0; j < len; j++) {
+                    std::complex<T> u = a[j], v = b[j];
+                    a[j] = u + v;
+                    b[j] = fft_multiply(u - v, w[j]);
+                }
+            }
+        }
+    }
+
+    // Transforms `fps` in place from bit-reversed order to natural order in decimation-in-time order,
+    // scaling the result by `1 / n`.
+    // Requires the size of `fps` to be a power of `2` not greater than `size()`.
+    void inverse(std::span<std::complex<T>> fps) const {
+        int n = static_cast<int>(fps.size());
+        assert(std::has_single_bit(unsigned(n)) && n <= _size);
+        _inverse_unscaled(fps);
+        for (std::complex<T> &c : fps) c /= n;
+    }
+
+    // Transforms `fps` in place as `forward(fps)`, on `hardware_threads()` threads if `parallel` and `fps` is large.
+    // The length is split as `rows * cols`: the stages that pair elements of the same column run on groups of columns
+    // small enough to stay in cache, then each row of `cols` contiguous elements is transformed independently.
+    // Requires the size of `fps` to be a power of `2` not greater than `size()`.
+    void forward(std::span<std::complex<T>> fps, bool parallel) const {
+        int n = static_cast<int>(fps.size());
+        if (!parallel || n < _PARALLEL_THRESHOLD) {
+            forward(fps);
+            return;
+        }
+        assert(std::has_single_bit(unsigned(n)) && n <= _size);
+        int cols = 1 << (std::countr_zero(unsigned(n)) / 2), rows = n / cols;
+        int width = std::max(1, _CACHE_ELEMENTS / rows);
+        parallel_for(cols, 1, [&](int, int64_t col_l, int64_t col_r) {
+            for (int c0 = col_l; c0 < col_r; c0 += width) {
+                int c1 = std::min<int64_t>(col_r, c0 + width);
+                for (int len = n / 2; len >= cols; len /= 2) {
+                    for (int i = 0; i < n; i += len * 2) {
+                        for (int q = 0; q < len; q += cols) {
+                            std::complex<T> *a = fps.data() + i + q, *b = a + len;
+                            const std::complex<T> *w = _roots.data() + len + q;
+                            for (int c = c0; c < c1; c++) {
+                                std::complex<T> u = a[c], v = b[c];
+                                a[c] = u + v;
+                                b[c] = fft_multiply(u - v, w[c]);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+        parallel_for(rows, 1, [&](int, int64_t row_l, int64_t row_r) {
+            for (int64_t r = row_l; r < row_r; r++) forward(fps.subspan(r * cols, cols));
+        });
+    }
+
+    // Transforms `fps` in place as `inverse(fps)`, on `hardware_threads()` threads if `parallel` and `fps` is large.
+    // Runs the steps of `forward(fps, true)` in reverse.
+    // Requires the size of `fps` to be a power of `2` not greater than `size()`.
+    void inverse(std::span<std::complex<T>> fps, bool parallel) const {
+        int n = static_cast<int>(fps.size());
+        if (!parallel || n < _PARALLEL_THRESHOLD) {
+            inverse(fps);
+            return;
+        }
+        assert(std::has_single_bit(unsigned(n)) && n <= _size);
+        int cols = 1 << (std::countr_zero(unsigned(n)) / 2), rows = n / cols;
+        int width = std::max(1, _CACHE_ELEMENTS / rows);
+        parallel_for(rows, 1, [&](int, int64_t row_l, int64_t row_r) {
+            for (int64_t r = row_l; r < row_r; r++) _inverse_unscaled(fps.subspan(r * cols, cols));
+        });
+        parallel_for(cols, 1, [&](int, int64_t col_l, int64_t col_r) {
+            for (int c0 = col_l; c0 < col_r; c0 += width) {
+                int c1 = std::min<int64_t>(col_r, c0 + width);
+                for (int len = cols; len < n; len *= 2) {
+                    for (int i = 0; i < n; i += len * 2) {
+                        for (int q = 0; q < len; q += cols) {
+                            std::complex<T> *a = fps.data() + i + q, *b = a + len;
+                            const std::complex<T> *w = _roots.data() + len + q;
+                            for (int c = c0; c < c1; c++) {
+                                std::complex<T> u = a[c], v = fft_multiply(b[c], std::conj(w[c]));
+                                a[c] = u + v;
+                                b[c] = u - v;
+                            }
+                        }
+                    }
+                }
+                for (int r = 0; r < rows; r++) {
+                    for (int c = c0; c < c1; c++) fps[r * cols + c] /= n;
+                }
+            }
+        });
+    }
+
+    // Multiplies `fps_l` by `fps_r` element-wise.
+    // Requires `fps_l` and `fps_r` to have the same size.
+    void multiply(std::span<std::complex<T>> fps_l, std::span<const std::complex<T>> fps_r) const {
+        assert(fps_l.size() == fps_r.size());
+        for (std::size_t i = 0; i < fps_l.size(); i++) fps_l[i] = fft_multiply(fps_l[i], fps_r[i]);
+    }
+
+    // Computes the convolution of two real-valued formal power series, reusing the plan's scratch buffer.
+    // Both inputs are packed into one complex transform as its real and imaginary parts.
+    // If `parallel`, large transforms run on `hardware_threads()` threads.
+    // If either vector is empty, returns an empty vector.
+    // Requires `fps_l.size() + fps_r.size() - 1 <= size()`.
+    std::vector<T> convolution(const std::vector<T> &fps_l, const std::vector<T> &fps_r, bool parallel = false) {
+        if (fps_l.empty() || fps_r.empty()) return {};
+        int len_l = static_cast<int>(fps_l.size()), len_r = static_cast<int>(fps_r.size());
+        int n = std::bit_ceil(unsigned(len_l + len_r - 1));
+        assert(n <= _size);
+        _buffer.assign(n, {});
+        for (int i = 0; i < len_l; i++) _buffer[i].real(fps_l[i]);
+        for (int i = 0; i < len_r; i++) _buffer[i].imag(fps_r[i]);
+        std::span<std::complex<T>> fps(_buffer);
+        forward(fps, parallel);
+
+        // In bit-reversed order, the frequencies `k` and `n - k` are mirrored within each block `[m, 2m)`.
+        // With `z = l + i * r`, the transform of `l * r` is `(z[k]^2 - conj(z[n - k])^2) / 4i`.
+        auto square_diff = [](std::complex<T> a, std::complex<T> b) {
+            std::complex<T> d = fft_multiply(a, a) - fft_multiply(std::conj(b), std::conj(b));
+            return std::complex<T>(d.imag() / 4, -d.real() / 4);
+        };
+        fps[0] = square_diff(fps[0], fps[0]);
+        if (n > 1) fps[1] = square_diff(fps[1], fps[1]);
+        for (int m = 2; m < n; m *= 2) {
+            for (int p = m, q = m * 2 - 1; p < q; p++, q--) {
+                std::complex<T> zp = fps[p], zq = fps[q];
+                fps[p] = square_diff(zp, zq);
+                fps[q] = square_diff(zq, zp);
+            }
+        }
+
+        inverse(fps, parallel);
+        std::vector<T> result(len_l + len_r - 1);
+        for (int i = 0; i < len_l + len_r - 1; i++) result[i] = fps[i].real();
+        return result;
+    }
+};
+
+// Returns a plan owned by the calling thread that supports transforms of length `n`.
+// The plan is rebuilt only when `n` exceeds its size.
+// Requires `n` to be a power of `2`.
+template <std::floating_point T> fft_plan<T>& shared_fft_plan(int n) {
+    thread_local fft_plan<T> plan;
+    if (plan.size() < n) plan = fft_plan<T>(n);
+    return plan;
+}
+
 // Performs a fast Fourier transform (or its inverse) on a vector of complex numbers.
 // Requires the size of `fps` to be a power of `2`.
 template <std::floating_point T> void fast_fourier_transform(std::vector<std::complex<T>> &fps, bool invert) {
     int n = static_cast<int>(fps.size());
+    assert(std::has_single_bit(unsigned(std::max(n, 1))));
     if (n <= 1) return;
-    std::vector<std::complex<T>> fps0(n / 2), fps1(n / 2);
-    for (int i = 0; i * 2 < n; i++) {
-        fps0[i] = fps[i * 2];
-        fps1[i] = fps[i * 2 + 1];
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(fps[i], fps[j]);
     }
-    fast_fourier_transform(fps0, invert);
-    fast_fourier_transform(fps1, invert);
-
-    T arg = std::numbers::pi_v<T> * 2 / n;
-    if (invert) arg = -arg;
-    std::complex<T> root(1), root_primitive(std::cos(arg), std::sin(arg));
-    for (int i = 0; i * 2 < n; i++) {
-        std::complex<T> u = fps0[i], v = root * fps1[i];
-        fps[i] = u + v;
-        fps[i + n / 2] = u - v;
-        root *= root_primitive;
-    }
-
+    const fft_plan<T> &plan = shared_fft_plan<T>(n);
     if (invert) {
-        for (std::complex<T> &c : fps) c /= 2;
+        plan.inverse(fps);
+    } else {
+        // The forward transform is the conjugate of the inverse transform of the conjugate.
+        for (std::complex<T> &c : fps) c = std::conj(c);
+        plan.inverse(fps);
+        for (std::complex<T> &c : fps) c = std::conj(c) * T(n);
     }
 }
 
 // Computes the convolution of two real-valued formal power series via fast Fourier transform.
+// If `parallel`, large transforms run on `hardware_threads()` threads.
 // If either vector is empty, returns an empty vector.
-template <std::floating_point T> std::vector<T> convolution(const std::vector<T> &fps_l, const std::vector<T> &fps_r) {
+template <std::floating_point T> std::vector<T> convolution(const std::vector<T> &fps_l, const std::vector<T> &fps_r, bool parallel = false) {
     if (fps_l.empty() || fps_r.empty()) return {};
-    int len = 1 << std::bit_width(fps_l.size() + fps_r.size() - 1);
-    int len_l = static_cast<int>(fps_l.size()), len_r = static_cast<int>(fps_r.size());
-    std::vector<std::complex<T>> nl(len), nr(len);
-    for (int i = 0; i < len_l; i++) nl[i] = fps_l[i];
-    for (int i = 0; i < len_r; i++) nr[i] = fps_r[i];
-    nl.resize(len);
-    nr.resize(len);
-    fast_fourier_transform(nl, false);
-    fast_fourier_transform(nr, false);
-    for (int i = 0; i < len; i++) nl[i] *= nr[i];
-    fast_fourier_transform(nl, true);
-    std::vector<T> result(len_l + len_r - 1);
-    for (int i = 0; i < len_l + len_r - 1; i++) result[i] = nl[i].real();
-    return result;
+    return shared_fft_plan<T>(std::bit_ceil(fps_l.size() + fps_r.size() - 1)).convolution(fps_l, fps_r, parallel);
 }
 
 // Returns the inverse of the formal power series up to the first `n` coefficients.
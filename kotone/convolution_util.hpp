@@ -3,7 +3,11 @@
 
 #include <vector>
 #include <algorithm>
-#include <atcoder/convolution>
+#include <numeric>
+#include <bit>
+#include <cassert>
+#include <atcoder/modint>
+#include <kotone/ntt>
 #include <kotone/internal_type_traits>
 
 namespace kotone {
@@ -22,6 +26,8 @@ template <typename T> std::vector<T> naive_convolution(const std::vector<T> &fps
 }
 
 // Returns the inverse of the formal power series up to the first `n` coefficients.
+// Each Newton step doubles the precision with five transforms of length `2m`:
+// the low half of `fps * result` is known to be `1`, so only its middle product is kept and multiplied back.
 // Requires `!fps.empty() && fps[0] != 0`.
 // Requires `n >= 0`.
 template <compatible_modint mint> std::vector<mint> inv_fps(const std::vector<mint> &fps, int n) {
@@ -29,18 +35,24 @@ template <compatible_modint mint> std::vector<mint> inv_fps(const std::vector<mi
     assert(!fps.empty() && fps[0] != 0);
     if (n == 0) return {};
     std::vector<mint> result{1 / fps[0]};
-    int m = 1;
+    result.reserve(std::bit_ceil(unsigned(n)));
     int len = static_cast<int>(fps.size());
-    while (m < n) {
-        m = std::min(m * 2, n);
-        std::vector<mint> sub(fps.begin(), fps.begin() + std::min(m, len));
-        if (m > len) sub.resize(m);
-        std::vector<mint> prod = atcoder::convolution(result, sub);
-        prod.resize(m);
-        prod[0] = 2 - prod[0];
-        for (int i = 1; i < m; i++) prod[i] = -prod[i];
-        result = atcoder::convolution(result, prod);
-        result.resize(m);
+    const ntt_plan<mint> &plan = shared_ntt_plan<mint>(std::bit_ceil(unsigned(n)));
+    std::vector<mint> prod, trans;
+    for (int m = 1; m < n; m *= 2) {
+        prod.assign(m * 2, mint{});
+        std::copy(fps.begin(), fps.begin() + std::min(m * 2, len), prod.begin());
+        trans.assign(m * 2, mint{});
+        std::copy(result.begin(), result.end(), trans.begin());
+        plan.forward(prod);
+        plan.forward(trans);
+        plan.multiply(prod, trans);
+        plan.inverse(prod);
+        std::fill(prod.begin(), prod.begin() + m, mint{});
+        plan.forward(prod);
+        plan.multiply(prod, trans);
+        plan.inverse(prod);
+        for (int i = m; i < m * 2; i++) result.push_back(-prod[i]);
     }
     result.resize(n);
     return result;
@@ -82,7 +94,7 @@ template <compatible_modint mint> std::vector<mint> log_fps(const std::vector<mi
     if (int len = fps.size(); len <= n) dfps = derivative(fps);
     else dfps = derivative(std::vector<mint>{fps.begin(), fps.begin() + n});
     std::vector<mint> ifps = inv_fps(fps, n - 1);
-    std::vector<mint> prod = atcoder::convolution(dfps, ifps);
+    std::vector<mint> prod = ntt_convolution(dfps, ifps);
     prod.resize(n - 1);
     std::vector<mint> result = integral(prod);
     result.resize(n);
@@ -90,29 +102,69 @@ template <compatible_modint mint> std::vector<mint> log_fps(const std::vector<mi
 }
 
 // Returns the exponential of the formal power series up to the first `n` coefficients.
+// Each Newton step updates `exp(fps)` and its inverse together, reusing transforms of both across the step.
+// The first half of a transform of length `2m` is the transform of length `m` of the same polynomial modulo `x^m - 1`.
 // Requires `fps.empty() || fps[0] == 0`.
 // Requires `n >= 0`.
+// Reference: https://arxiv.org/abs/0910.1926
 template <compatible_modint mint> std::vector<mint> exp_fps(const std::vector<mint> &fps, int n) {
-    assert(fps.empty || fps[0] == 0);
+    assert(fps.empty() || fps[0] == 0);
     assert(n >= 0);
     if (n == 0) return {};
-    std::vector<mint> result{1};
-    if (fps.empty()) {
-        result.resize(n);
-        return result;
-    }
-    int m = 1;
-    while (m < n) {
-        m = std::min(m * 2, n);
-        std::vector<mint> log = log_fps(result, m);
-        for (int i = 0; i < m; i++) {
-            log[i] = -log[i];
-            if (i < static_cast<int>(fps.size())) log[i] += fps[i];
+    if (n == 1) return {1};
+    int len = static_cast<int>(fps.size());
+    const ntt_plan<mint> &plan = shared_ntt_plan<mint>(std::bit_ceil(unsigned(n)));
+
+    // `result` approximates `exp(fps)` and `inv` approximates its inverse with half the precision.
+    // `inv_trans` holds the transform of `inv` of twice its length.
+    std::vector<mint> result{1, len > 1 ? fps[1] : mint{}}, inv{1}, inv_trans{1, 1};
+    std::vector<mint> trans, prev, prod;
+    for (int m = 2; m < n; m *= 2) {
+        trans.assign(m * 2, mint{});
+        std::copy(result.begin(), result.end(), trans.begin());
+        plan.forward(trans);
+
+        // Extends `inv` to `m` coefficients by one Newton step against `result`.
+        prev.swap(inv_trans);
+        prod.assign(trans.begin(), trans.begin() + m);
+        plan.multiply(prod, prev);
+        plan.inverse(prod);
+        std::fill(prod.begin(), prod.begin() + m / 2, mint{});
+        plan.forward(prod);
+        for (int i = 0; i < m; i++) prod[i] *= -prev[i];
+        plan.inverse(prod);
+        inv.insert(inv.end(), prod.begin() + m / 2, prod.end());
+        inv_trans.assign(m * 2, mint{});
+        std::copy(inv.begin(), inv.end(), inv_trans.begin());
+        plan.forward(inv_trans);
+
+        // Computes `fps' - result' / result` modulo `x^(2m - 1)` from its known low part.
+        prod.assign(m, mint{});
+        for (int i = 1; i < std::min(len, m); i++) prod[i - 1] = fps[i] * i;
+        plan.forward(prod);
+        plan.multiply(prod, std::span<const mint>(trans.begin(), m));
+        plan.inverse(prod);
+        for (int i = 1; i < m; i++) prod[i - 1] -= result[i] * i;
+        prod.resize(m * 2);
+        for (int i = 0; i < m - 1; i++) {
+            prod[m + i] = prod[i];
+            prod[i] = 0;
         }
-        log[0] += 1;
-        result = atcoder::convolution(result, log);
-        result.resize(m);
+        plan.forward(prod);
+        plan.multiply(prod, inv_trans);
+        plan.inverse(prod);
+        prod.pop_back();
+        prod = integral(prod);
+
+        // Multiplies `result` by `1 + fps - log(result)`, whose low `m` coefficients are `1`.
+        for (int i = m; i < std::min(len, m * 2); i++) prod[i] += fps[i];
+        std::fill(prod.begin(), prod.begin() + m, mint{});
+        plan.forward(prod);
+        plan.multiply(prod, trans);
+        plan.inverse(prod);
+        result.insert(result.end(), prod.begin() + m, prod.end());
     }
+    result.resize(n);
     return result;
 }
 
@@ -161,23 +213,102 @@ template <compatible_modint mint> mint bostan_mori(std::vector<mint> numerator,
     assert(k >= 0);
     if (numerator.empty()) return 0;
 
-    while (k) {
-        std::vector<mint> denom_neg = denominator;
-        for (unsigned i = 1; i < denom_neg.size(); i += 2) {
-            denom_neg[i] = -denom_neg[i];
+    // Both series stay transformed at length `2n` between steps.
+    // In bit-reversed order, the values at `w` and `-w` sit at adjacent positions,
+    // so `Q(-x)` is read off `Q(x)` and each halving step only extends the halves back to length `2n`.
+    int n = std::bit_ceil(std::max(numerator.size(), denominator.size()));
+    const ntt_plan<mint> &plan = shared_ntt_plan<mint>(n * 2);
+    numerator.resize(n * 2);
+    denominator.resize(n * 2);
+    plan.forward(numerator);
+    plan.forward(denominator);
+    for (; k; k /= 2) {
+        for (int i = 0; i < n * 2; i += 2) {
+            mint q0 = denominator[i], q1 = denominator[i + 1];
+            numerator[i] *= q1;
+            numerator[i + 1] *= q0;
+            denominator[i] = denominator[i + 1] = q0 * q1;
         }
-        numerator = atcoder::convolution(numerator, denom_neg);
-        denominator = atcoder::convolution(denominator, denom_neg);
-
-        std::vector<mint> new_num, new_denom;
-        for (unsigned i = k & 1; i < numerator.size(); i += 2) new_num.push_back(numerator[i]);
-        for (unsigned i = 0; i < denominator.size(); i += 2) new_denom.push_back(denominator[i]);
-        numerator = new_num;
-        denominator = new_denom;
-        k /= 2;
+        plan.halve(numerator, k & 1);
+        plan.halve(denominator, false);
+        if (k == 1) break;
+        plan.extend(numerator);
+        plan.extend(denominator);
+    }
+
+    // The first `n` values form a transform of length `n`, whose sum is `n` times the constant term.
+    mint num_sum = std::accumulate(numerator.begin(), numerator.begin() + n, mint{});
+    mint denom_sum = std::accumulate(denominator.begin(), denominator.begin() + n, mint{});
+    return num_sum / denom_sum;
+}
+
+// Computes the coefficients of the terms with each of the specified degrees `ks` in the rational function.
+// All queries share the chain of denominators `Q(x) Q(-x)`, kept in transformed form,
+// and queries whose degrees agree in their lowest bits share the numerator steps as well.
+// Requires `!denominator.empty() && denominator[0] != 0`.
+// Requires `k >= 0` for each `k` in `ks`.
+template <compatible_modint mint> std::vector<mint> bostan_mori(const std::vector<mint> &numerator, const std::vector<mint> &denominator, const std::vector<int64_t> &ks) {
+    assert(!denominator.empty() && denominator[0] != 0);
+    int q = ks.size();
+    std::vector<mint> result(q);
+    if (numerator.empty() || q == 0) return result;
+    assert(*std::min_element(ks.begin(), ks.end()) >= 0);
+    int levels = std::bit_width(uint64_t(*std::max_element(ks.begin(), ks.end())));
+    int n = std::bit_ceil(std::max(numerator.size(), denominator.size()));
+    const ntt_plan<mint> &plan = shared_ntt_plan<mint>(n * 2);
+
+    // `chain[t]` holds the transform of length `2n` of the `t`-th denominator.
+    std::vector<std::vector<mint>> chain(levels + 1);
+    std::vector<mint> chain_sum(levels + 1);
+    chain[0] = denominator;
+    chain[0].resize(n * 2);
+    plan.forward(chain[0]);
+    for (int t = 0; t <= levels; t++) {
+        chain_sum[t] = std::accumulate(chain[t].begin(), chain[t].begin() + n, mint{});
+        if (t == levels) break;
+        chain[t + 1] = chain[t];
+        std::vector<mint> &denom = chain[t + 1];
+        for (int i = 0; i < n * 2; i += 2) denom[i] = denom[i + 1] = denom[i] * denom[i + 1];
+        plan.halve(denom, false);
+        plan.extend(denom);
     }
 
-    return numerator[0] / denominator[0];
+    // Walks the lowest bits of the queries depth-first.
+    // Each frame holds the transform of length `n` of its numerator in the first half of `trans`.
+    struct frame {
+        int t;
+        std::vector<mint> trans;
+        std::vector<int> ids;
+    };
+    std::vector<frame> stack(1, {0, numerator, std::vector<int>(q)});
+    std::iota(stack[0].ids.begin(), stack[0].ids.end(), 0);
+    stack[0].trans.resize(n * 2);
+    plan.forward(stack[0].trans);
+    while (!stack.empty()) {
+        frame cur = std::move(stack.back());
+        stack.pop_back();
+        mint ratio = std::accumulate(cur.trans.begin(), cur.trans.begin() + n, mint{}) / chain_sum[cur.t];
+        std::vector<int> ids[2];
+        for (int id : cur.ids) {
+            int64_t k = ks[id] >> cur.t;
+            if (k == 0) result[id] = ratio;
+            else ids[k & 1].push_back(id);
+        }
+        if (ids[0].empty() && ids[1].empty()) continue;
+        if (cur.t > 0) plan.extend(cur.trans);
+        const std::vector<mint> &denom = chain[cur.t];
+        for (int i = 0; i < n * 2; i += 2) {
+            cur.trans[i] *= denom[i + 1];
+            cur.trans[i + 1] *= denom[i];
+        }
+        for (int b = 0; b < 2; b++) {
+            if (ids[b].empty()) continue;
+            std::vector<mint> next = b == 0 && !ids[1].empty() ? cur.trans : std::move(cur.trans);
+            plan.halve(next, b);
+            stack.push_back({cur.t + 1, std::move(next), std::move(ids[b])});
+        }
+    }
+    return result;
 }
 
 // Computes term `a[k]` of a homogeneous linear recurrence `a` of order `n`.
@@ -194,11 +325,27 @@ template <compatible_modint mint> mint solve_recurrence(const std::vector<mint>
     if (k < n) return init[k];
     std::vector<mint> denominator(n + 1, 1);
     for (int i = 0; i < n; i++) denominator[i + 1] = -recurrence[i];
-    std::vector<mint> numerator = atcoder::convolution(init, denominator);
+    std::vector<mint> numerator = ntt_convolution(init, denominator);
     numerator.resize(n);
     return bostan_mori(numerator, denominator, k);
 }
 
+// Computes terms `a[k]` for each `k` in `ks` of a homogeneous linear recurrence `a` of order `n`,
+// sharing the work between queries as in the batched `bostan_mori`.
+// Returns a vector of `0`'s if either `recurrence` or `init` is empty.
+// Requires `recurrence.size() == init.size()`.
+// Requires `k >= 0` for each `k` in `ks`.
+template <compatible_modint mint> std::vector<mint> solve_recurrence(const std::vector<mint> &recurrence, const std::vector<mint> &init, const std::vector<int64_t> &ks) {
+    assert(recurrence.size() == init.size());
+    int n = int(recurrence.size());
+    if (n == 0) return std::vector<mint>(ks.size());
+    std::vector<mint> denominator(n + 1, 1);
+    for (int i = 0; i < n; i++) denominator[i + 1] = -recurrence[i];
+    std::vector<mint> numerator = ntt_convolution(init, denominator);
+    numerator.resize(n);
+    return bostan_mori(numerator, denominator, ks);
+}
+
 }  // namespace kotone
 
 #endif  // KOTONE_CONVOLUTION_UTIL_HPP
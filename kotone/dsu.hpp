@@ -2,9 +2,13 @@
 #define KOTONE_DSU_HPP 1
 
 #include <vector>
+#include <span>
+#include <atomic>
+#include <utility>
 #include <cassert>
 #include <algorithm>
 #include <kotone/internal_type_traits>
+#include <kotone/internal_parallel>
 
 namespace kotone {
 
@@ -29,6 +33,19 @@ template <
         return _p[v];
     }
 
+    // Links the distinct leaders `u` and `v` with `pd` as the potential difference from `u` to `v`.
+    int _link(int u, int v, pd_type pd) {
+        if (_parent_or_size[u] > _parent_or_size[v]) {
+            std::swap(u, v);
+            pd = -pd;
+        }
+        _parent_or_size[u] += _parent_or_size[v];
+        _parent_or_size[v] = u;
+        _p[v] = pd;
+        if constexpr (on_merge) on_merge(u, v);
+        return u;
+    }
+
   public:
     // Initializes DSU with an empty graph.
     dsu() {}
@@ -62,10 +79,22 @@ template <
     // Requires `0 <= v < num_nodes`.
     int leader(int v) {
         assert(0 <= v && v < num_nodes());
-        if (_parent_or_size[v] < 0) return v;
-        int l = leader(_parent_or_size[v]);
-        _p[v] = _p[v] + _p[_parent_or_size[v]];
-        return _parent_or_size[v] = l;
+        int root = v;
+        pd_type total{};
+        while (_parent_or_size[root] >= 0) {
+            total = total + _p[root];
+            root = _parent_or_size[root];
+        }
+        // `total` is the potential of the current node relative to the root.
+        while (_parent_or_size[v] >= 0 && _parent_or_size[v] != root) {
+            int next = _parent_or_size[v];
+            pd_type rest = total - _p[v];
+            _p[v] = total;
+            _parent_or_size[v] = root;
+            total = rest;
+            v = next;
+        }
+        return root;
     }
 
     // Returns whether `u` and `v` belong to the same connected component.
@@ -86,19 +115,24 @@ template <
     // Chooses the new leader via union by size.
     // Calls `on_merge` if provided.
     int merge(int u, int v, pd_type pd = {}) {
-        if (connected(u, v)) return leader(u);
-        pd = pd + _potential(u) - _potential(v);
-        u = leader(u);
-        v = leader(v);
-        if (_parent_or_size[u] > _parent_or_size[v]) {
-            std::swap(u, v);
-            pd = -pd;
+        int lu = leader(u), lv = leader(v);
+        if (lu == lv) return lu;
+        // After `leader`, each node points at its root, so `_p` holds its potential (and is zero at a root).
+        return _link(lu, lv, pd + _p[u] - _p[v]);
+    }
+
+    // Calls `merge(u, v)` for each pair `(u, v)` in `edges` in order,
+    // then returns the number of merges that joined two distinct components.
+    // Calls `on_merge` if provided.
+    int merge_batch(std::span<const std::pair<int, int>> edges) {
+        int result = 0;
+        for (auto [u, v] : edges) {
+            int lu = leader(u), lv = leader(v);
+            if (lu == lv) continue;
+            _link(lu, lv, _p[u] - _p[v]);
+            result++;
         }
-        _parent_or_size[u] += _parent_or_size[v];
-        _parent_or_size[v] = u;
-        _p[v] = pd;
-        if constexpr (on_merge) on_merge(u, v);
-        return u;
+        return result;
     }
 
     // Returns the size of the connected component containing `v`.
@@ -122,6 +156,124 @@ template <
     }
 };
 
+// A union-find that supports `merge`, `leader` and `connected` from multiple threads at once.
+// Trees are linked by index (the smaller leader goes under the larger one) with a compare-and-swap,
+// and `leader` shortens paths by path splitting, also with compare-and-swap.
+// Unlike `dsu`, it does not track sizes or potential differences.
+//
+// Reference: R. J. Anderson and H. Woll, Wait-free Parallel Algorithms for the Union-Find Problem
+struct concurrent_dsu {
+  private:
+    std::vector<std::atomic<int>> _parent;
+
+  public:
+    // Initializes DSU with an empty graph.
+    concurrent_dsu() {}
+
+    // Initializes DSU with the specified `num_nodes` and no edges.
+    // Requires `num_nodes >= 0`.
+    concurrent_dsu(int num_nodes) : _parent(num_nodes) {
+        assert(num_nodes >= 0);
+        parallel_for(num_nodes, 1 << 16, [&](int, int64_t l, int64_t r) {
+            for (int64_t v = l; v < r; v++) _parent[v].store(v, std::memory_order_relaxed);
+        });
+    }
+
+    // Returns the number of nodes.
+    int num_nodes() const noexcept {
+        return _parent.size();
+    }
+
+    // Returns the leader of the connected component containing `v`.
+    // When called concurrently with `merge`, the result was the leader at some point during the call.
+    // Requires `0 <= v < num_nodes`.
+    int leader(int v) {
+        assert(0 <= v && v < num_nodes());
+        // Parents only ever move towards the root, so relaxed accesses cannot create cycles.
+        int p = _parent[v].load(std::memory_order_relaxed);
+        while (p != v) {
+            int g = _parent[p].load(std::memory_order_relaxed);
+            // A failed exchange overwrites its expected value, so it must not be `p`.
+            int expected = p;
+            if (g != p) _parent[v].compare_exchange_weak(expected, g, std::memory_order_relaxed);
+            v = p;
+            p = g;
+        }
+        return v;
+    }
+
+    // Returns whether `u` and `v` belong to the same connected component.
+    // When called concurrently with `merge`, the result was true at some point during the call.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    bool connected(int u, int v) {
+        while (true) {
+            u = leader(u);
+            v = leader(v);
+            if (u == v) return true;
+            if (_parent[u].load(std::memory_order_relaxed) == u) return false;
+        }
+    }
+
+    // Adds an edge between `u` and `v`, then returns whether two distinct components were joined.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    bool merge(int u, int v) {
+        while (true) {
+            u = leader(u);
+            v = leader(v);
+            if (u == v) return false;
+            if (u > v) std::swap(u, v);
+            int expected = u;
+            if (_parent[u].compare_exchange_strong(expected, v, std::memory_order_acq_rel)) return true;
+        }
+    }
+
+    // Adds an edge between `u` and `v` for each pair `(u, v)` in `edges`, on `hardware_threads()` threads,
+    // then returns the number of merges that joined two distinct components.
+    // Requires every node in `edges` to be in `[0, num_nodes)`.
+    int64_t merge_batch(std::span<const std::pair<int, int>> edges) {
+        std::vector<int64_t> merged(parallel_blocks(edges.size(), 1 << 16));
+        parallel_for(edges.size(), 1 << 16, [&](int block, int64_t l, int64_t r) {
+            for (int64_t i = l; i < r; i++) merged[block] += merge(edges[i].first, edges[i].second);
+        });
+        int64_t result = 0;
+        for (int64_t m : merged) result += m;
+        return result;
+    }
+
+    // Returns the leader of every node, computed on `hardware_threads()` threads.
+    // Requires no concurrent calls to `merge`.
+    std::vector<int> leaders() {
+        int n = num_nodes();
+        std::vector<int> result(n);
+        parallel_for(n, 1 << 16, [&](int, int64_t l, int64_t r) {
+            for (int64_t v = l; v < r; v++) result[v] = leader(v);
+        });
+        return result;
+    }
+
+    // Returns a vector of connected components as vectors of node indices.
+    // The order of components is undefined.
+    // Each component contains member nodes in ascending order.
+    // Labels all nodes on `hardware_threads()` threads, then groups them in one pass.
+    // Requires no concurrent calls to `merge`.
+    std::vector<std::vector<int>> components() {
+        int n = num_nodes();
+        std::vector<int> label = leaders(), slot(n, -1);
+        std::vector<std::vector<int>> result;
+        for (int v = 0; v < n; v++) {
+            int &s = slot[label[v]];
+            if (s == -1) {
+                s = result.size();
+                result.emplace_back();
+            }
+            result[s].push_back(v);
+        }
+        return result;
+    }
+};
+
 }  // namespace kotone
 
 #endif  // KOTONE_DSU_HPP
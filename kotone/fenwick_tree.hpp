@@ -2,20 +2,36 @@
 #define KOTONE_FENWICK_TREE_HPP 1
 
 #include <vector>
+#include <algorithm>
+#include <bit>
+#include <concepts>
 #include <cassert>
 #include <kotone/unordered_map>
 #include <kotone/internal_type_traits>
 
 namespace kotone {
 
-// A Fenwick tree for a sparse collection of values over an interval.
+// A Fenwick tree for a collection of values over an interval.
+// Values are stored in a hash map by default, or in a contiguous array in dense mode.
 template <mutable_additive T> struct fenwick_tree {
   private:
     int64_t _len{};
+    bool _dense = false;
+    std::vector<T> _data;
     unordered_map<int64_t, T> _map;
 
+    T _get(int64_t pos) const {
+        if (_dense) return _data[pos];
+        auto iter = _map.find(pos);
+        return iter != _map.end() ? iter->second : T{};
+    }
+
     T _sum(int64_t pos) const {
         T acc{};
+        if (_dense) {
+            for (; pos; pos -= pos & -pos) acc += _data[pos];
+            return acc;
+        }
         for (; pos; pos -= pos & -pos) {
             auto iter = _map.find(pos);
             if (iter != _map.end()) acc += iter->second;
@@ -27,15 +43,44 @@ template <mutable_additive T> struct fenwick_tree {
     fenwick_tree() {}
 
     // Constructs a Fenwick tree for the specified length.
+    // If `dense == true`, stores values in an array of `length + 1` elements instead of a hash map.
     // Requires `length >= 0`.
-    fenwick_tree(int64_t length) : _len(length + 1) {
+    fenwick_tree(int64_t length, bool dense = false) : _len(length + 1), _dense(dense) {
         assert(length >= 0);
+        if (dense) _data.resize(_len);
+    }
+
+    // Constructs a dense Fenwick tree initialized with the values of `vec`.
+    fenwick_tree(const std::vector<T> &vec) {
+        build(vec);
+    }
+
+    // Reinitializes the Fenwick tree in dense mode with the values of `vec` in O(n) time.
+    void build(const std::vector<T> &vec) {
+        _len = vec.size() + 1;
+        _dense = true;
+        _map = unordered_map<int64_t, T>();
+        _data.assign(_len, T{});
+        for (int64_t i = 1; i < _len; i++) {
+            _data[i] += vec[i - 1];
+            int64_t j = i + (i & -i);
+            if (j < _len) _data[j] += _data[i];
+        }
+    }
+
+    // Returns whether the Fenwick tree stores its values in a contiguous array.
+    bool is_dense() const {
+        return _dense;
     }
 
     // Increments the value at the specified position.
     // Requires `pos` to be a valid index.
     void add(int64_t pos, T val) {
         assert(0 <= pos && pos + 1 < _len);
+        if (_dense) {
+            for (++pos; pos < _len; pos += pos & -pos) _data[pos] += val;
+            return;
+        }
         for (++pos; pos < _len; pos += pos & -pos) _map[pos] += val;
     }
 
@@ -46,9 +91,85 @@ template <mutable_additive T> struct fenwick_tree {
         assert(0 <= low && low <= high && high < _len);
         return _sum(high) - _sum(low);
     }
+
+    // Returns the minimum `r` such that `sum(0, r) >= val`, or `length + 1` if no such `r` exists.
+    // Requires all values to be non-negative.
+    int64_t lower_bound(T val) const requires std::totally_ordered<T> {
+        if (!(T{} < val)) return 0;
+        int64_t pos = 0;
+        T acc{};
+        for (int64_t step = std::bit_floor(uint64_t(std::max<int64_t>(_len - 1, 1))); step; step >>= 1) {
+            if (pos + step >= _len) continue;
+            T next = acc + _get(pos + step);
+            if (next < val) {
+                pos += step;
+                acc = next;
+            }
+        }
+        return pos + 1;
+    }
+};
+
+// A Fenwick tree that supports adding a value to every element of an interval.
+// Maintains prefix sums as `sum(0, p) = p * slope(p) + offset(p)` with two Fenwick trees.
+template <mutable_additive T> requires std::constructible_from<T, int64_t> && requires(T a, T b) {
+    { a * b } -> std::convertible_to<T>;
+} struct range_fenwick_tree {
+  private:
+    int64_t _len{};
+    fenwick_tree<T> _slope, _offset;
+
+    T _sum(int64_t pos) const {
+        return T(pos) * _slope.sum(0, pos) + _offset.sum(0, pos);
+    }
+
+  public:
+    range_fenwick_tree() {}
+
+    // Constructs a Fenwick tree for the specified length with all values initialized to zero.
+    // If `dense == true`, stores values in arrays instead of hash maps.
+    // Requires `length >= 0`.
+    range_fenwick_tree(int64_t length, bool dense = false)
+        : _len(length + 1), _slope(length + 1, dense), _offset(length + 1, dense) {
+        assert(length >= 0);
+    }
+
+    // Constructs a dense Fenwick tree initialized with the values of `vec` in O(n) time.
+    range_fenwick_tree(const std::vector<T> &vec) : _len(vec.size() + 1), _slope(_len, true) {
+        std::vector<T> offset(vec);
+        offset.emplace_back();
+        _offset.build(offset);
+    }
+
+    // Increments every value in the interval `[low, high)`.
+    // Requires `low` and `high` to be within the Fenwick tree's interval.
+    // Requires `low <= high`.
+    void add(int64_t low, int64_t high, T val) {
+        assert(0 <= low && low <= high && high < _len);
+        _slope.add(low, val);
+        _slope.add(high, -val);
+        _offset.add(low, -(T(low) * val));
+        _offset.add(high, T(high) * val);
+    }
+
+    // Increments the value at the specified position.
+    // Requires `pos` to be a valid index.
+    void add(int64_t pos, T val) {
+        assert(0 <= pos && pos + 1 < _len);
+        _offset.add(pos, val);
+    }
+
+    // Returns the sum of the interval `[low, high)`.
+    // Requires `low` and `high` to be within the Fenwick tree's interval.
+    // Requires `low <= high`.
+    T sum(int64_t low, int64_t high) const {
+        assert(0 <= low && low <= high && high < _len);
+        return _sum(high) - _sum(low);
+    }
 };
 
 // A two-dimensional Fenwick tree for matrices with a small height and a large width.
+// In dense mode, the tree is stored in a single row-major array instead of sparse rows.
 // Reference: https://nyaannyaan.github.io/library/data-structure-2d/dynamic-binary-indexed-tree-2d.hpp
 template <mutable_additive T> struct fenwick_tree_2d {
   private:
@@ -56,17 +177,75 @@ template <mutable_additive T> struct fenwick_tree_2d {
 
     int _height{};
     int64_t _width{};
+    bool _dense = false;
     std::vector<bit> _bits;
+    std::vector<T> _data;
+
+    T* _row(int i) {
+        return _data.data() + i * (_width + 1);
+    }
+
+    const T* _row(int i) const {
+        return _data.data() + i * (_width + 1);
+    }
+
+    T _row_sum(int i, int64_t j) const {
+        if (!_dense) return _bits[i].sum(0, j);
+        const T *row = _row(i);
+        T acc{};
+        for (; j; j -= j & -j) acc += row[j];
+        return acc;
+    }
 
   public:
     fenwick_tree_2d() {}
 
     // Constructs a two-dimensional Fenwick tree for a matrix of the specified dimension.
+    // If `dense == true`, stores values in an array of `(height + 1) * (width + 1)` elements.
     // Requires `height >= 0`.
     // Requires `width >= 0`.
-    fenwick_tree_2d(int height, int64_t width) : _height(height + 1), _width(width), _bits(_height, bit(_width)) {
+    fenwick_tree_2d(int height, int64_t width, bool dense = false) : _height(height + 1), _width(width), _dense(dense) {
         assert(height >= 0);
         assert(width >= 0);
+        if (dense) _data.resize(_height * (_width + 1));
+        else _bits.assign(_height, bit(_width));
+    }
+
+    // Constructs a dense two-dimensional Fenwick tree initialized with the values of `matrix`.
+    // Requires all rows of `matrix` to have the same length.
+    fenwick_tree_2d(const std::vector<std::vector<T>> &matrix) {
+        build(matrix);
+    }
+
+    // Reinitializes the Fenwick tree in dense mode with the values of `matrix` in O(height * width) time.
+    // Requires all rows of `matrix` to have the same length.
+    void build(const std::vector<std::vector<T>> &matrix) {
+        _height = matrix.size() + 1;
+        _width = matrix.empty() ? 0 : matrix[0].size();
+        _dense = true;
+        _bits.clear();
+        _data.assign(_height * (_width + 1), T{});
+        for (int i = 1; i < _height; i++) {
+            assert(int64_t(matrix[i - 1].size()) == _width);
+            T *row = _row(i);
+            for (int64_t j = 1; j <= _width; j++) {
+                row[j] += matrix[i - 1][j - 1];
+                int64_t k = j + (j & -j);
+                if (k <= _width) row[k] += row[j];
+            }
+        }
+        for (int i = 1; i < _height; i++) {
+            int k = i + (i & -i);
+            if (k >= _height) continue;
+            const T *row = _row(i);
+            T *parent = _row(k);
+            for (int64_t j = 1; j <= _width; j++) parent[j] += row[j];
+        }
+    }
+
+    // Returns whether the Fenwick tree stores its values in a contiguous array.
+    bool is_dense() const {
+        return _dense;
     }
 
     // Increments the value at position `(i, j)` in the matrix.
@@ -75,7 +254,14 @@ template <mutable_additive T> struct fenwick_tree_2d {
     void add(int i, int64_t j, T val) {
         assert(0 <= i && i + 1 < _height);
         assert(0 <= j && j < _width);
-        for (++i; i < _height; i += i & -i) _bits[i].add(j, val);
+        if (!_dense) {
+            for (++i; i < _height; i += i & -i) _bits[i].add(j, val);
+            return;
+        }
+        for (++i; i < _height; i += i & -i) {
+            T *row = _row(i);
+            for (int64_t k = j + 1; k <= _width; k += k & -k) row[k] += val;
+        }
     }
 
     // Returns the sum of the submatrix in `[0, i) * [0, j)`.
@@ -86,7 +272,7 @@ template <mutable_additive T> struct fenwick_tree_2d {
         assert(0 <= j && j <= _width);
         T acc{};
         for (; i; i -= i & -i) {
-            acc += _bits[i].sum(0, j);
+            acc += _row_sum(i, j);
         }
         return acc;
     }
@@ -100,10 +286,10 @@ template <mutable_additive T> struct fenwick_tree_2d {
         T acc{};
         while (li != ri) {
             if (li < ri) {
-                acc += _bits[ri].sum(lj, rj);
+                acc += _row_sum(ri, rj) - _row_sum(ri, lj);
                 ri -= ri & -ri;
             } else {
-                acc -= _bits[li].sum(lj, rj);
+                acc -= _row_sum(li, rj) - _row_sum(li, lj);
                 li -= li & -li;
             }
         }
@@ -111,6 +297,83 @@ template <mutable_additive T> struct fenwick_tree_2d {
     }
 };
 
+// A two-dimensional Fenwick tree whose updates are restricted to a set of points known in advance.
+// Each node of the outer tree stores the sorted `y`-coordinates of its points and an inner Fenwick tree over them,
+// all in contiguous arrays, so memory usage is O(n log n) for `n` points regardless of the coordinate range.
+template <mutable_additive T> struct static_fenwick_tree_2d {
+  private:
+    std::vector<int64_t> _xs, _ys;
+    std::vector<int> _offsets;
+    std::vector<T> _data;
+
+    int _count_less(const std::vector<int64_t> &vec, int low, int high, int64_t val) const {
+        return std::lower_bound(vec.begin() + low, vec.begin() + high, val) - vec.begin() - low;
+    }
+
+    T _prefix(int node, int64_t y) const {
+        int low = _offsets[node];
+        T acc{};
+        for (int k = _count_less(_ys, low, _offsets[node + 1], y); k; k -= k & -k) acc += _data[low + k - 1];
+        return acc;
+    }
+
+    T _sum(int x_count, int64_t low_y, int64_t high_y) const {
+        T acc{};
+        for (int i = x_count; i; i -= i & -i) acc += _prefix(i, high_y) - _prefix(i, low_y);
+        return acc;
+    }
+
+  public:
+    static_fenwick_tree_2d() {}
+
+    // Constructs a Fenwick tree that accepts updates at the specified points `(x, y)`.
+    // All values are initialized to zero.
+    static_fenwick_tree_2d(const std::vector<std::pair<int64_t, int64_t>> &points) {
+        for (auto [x, y] : points) _xs.push_back(x);
+        std::sort(_xs.begin(), _xs.end());
+        _xs.erase(std::unique(_xs.begin(), _xs.end()), _xs.end());
+        int n = _xs.size();
+        std::vector<std::vector<int64_t>> node_ys(n + 1);
+        for (auto [x, y] : points) {
+            int i = _count_less(_xs, 0, n, x) + 1;
+            for (; i <= n; i += i & -i) node_ys[i].push_back(y);
+        }
+        _offsets.assign(n + 2, 0);
+        for (int i = 1; i <= n; i++) {
+            std::sort(node_ys[i].begin(), node_ys[i].end());
+            node_ys[i].erase(std::unique(node_ys[i].begin(), node_ys[i].end()), node_ys[i].end());
+            _offsets[i + 1] = _offsets[i] + node_ys[i].size();
+            _ys.insert(_ys.end(), node_ys[i].begin(), node_ys[i].end());
+        }
+        _data.assign(_ys.size(), T{});
+    }
+
+    // Increments the value at point `(x, y)`.
+    // Requires `(x, y)` to be one of the points specified on construction.
+    void add(int64_t x, int64_t y, T val) {
+        int n = _xs.size();
+        int i = _count_less(_xs, 0, n, x);
+        assert(i < n && _xs[i] == x);
+        for (++i; i <= n; i += i & -i) {
+            int low = _offsets[i], high = _offsets[i + 1];
+            int k = _count_less(_ys, low, high, y);
+            assert(k < high - low && _ys[low + k] == y);
+            for (++k; k <= high - low; k += k & -k) _data[low + k - 1] += val;
+        }
+    }
+
+    // Returns the sum of the values at points in `[low_x, high_x) * [low_y, high_y)`.
+    // Requires `low_x <= high_x`.
+    // Requires `low_y <= high_y`.
+    T sum(int64_t low_x, int64_t low_y, int64_t high_x, int64_t high_y) const {
+        assert(low_x <= high_x);
+        assert(low_y <= high_y);
+        int n = _xs.size();
+        int low = _count_less(_xs, 0, n, low_x), high = _count_less(_xs, 0, n, high_x);
+        return _sum(high, low_y, high_y) - _sum(low, low_y, high_y);
+    }
+};
+
 }  // namespace kotone
 
 #endif  // KOTONE_FENWICK_TREE
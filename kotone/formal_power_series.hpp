@@ -3,13 +3,20 @@
 
 #include <vector>
 #include <algorithm>
+#include <bit>
+#include <span>
 #include <cassert>
-#include <atcoder/convolution>
+#include <atcoder/modint>
+#include <kotone/ntt>
+#include <kotone/convolution_util>
 #include <kotone/internal_type_traits>
 
 namespace kotone {
 
 // A formal power series (`fps`) inherited from `vector<mint>` that supports various operations.
+// If `using_ntt` is `true`, multiplication uses number theoretic transforms, directly for NTT-friendly moduli
+// and via three NTT-friendly primes and the Chinese remainder theorem otherwise.
+// If `using_ntt` is `false`, multiplication is performed naively.
 template <compatible_modint mint, bool using_ntt = true> struct formal_power_series : std::vector<mint> {
     using fps = formal_power_series;
     using std::vector<mint>::vector;
@@ -32,7 +39,7 @@ template <compatible_modint mint, bool using_ntt = true> struct formal_power_ser
     // Multiplies `*this` by `other`.
     fps& operator*=(const fps &other) {
         if (this->empty() || other.empty()) this->clear();
-        else if constexpr (using_ntt) *this = atcoder::convolution(*this, other);
+        else if constexpr (using_ntt) *this = ntt_convolution(*this, other);
         else {
             fps result(this->size() + other.size() - 1);
             for (std::size_t i = 0; i < this->size(); i++) {
@@ -111,26 +118,10 @@ template <compatible_modint mint, bool using_ntt = true> struct formal_power_ser
     }
 
     // Returns a `vector` containing the results of evaluating `*this` at each point in `vec`.
+    // Uses the transposed (middle product) algorithm on the subproduct tree of `vec`.
     std::vector<mint> eval(const std::vector<mint> &vec) {
-        int m = vec.size(), len = 1;
-        while (len < m) len *= 2;
-        std::vector<fps> nodes(len * 2);
-        for (int i = 0; i < m; i++) nodes[len + i] = {-vec[i], 1};
-        for (int i = m; i < len; i++) nodes[len + i] = {1};
-        for (int i = len - 1; i > 0; i--) nodes[i] = nodes[i * 2] * nodes[i * 2 + 1];
-        std::vector<mint> result(m);
-        auto solve = [&](auto &solve, int i, fps poly) {
-            if (i >= len + m) return;
-            poly %= nodes[i];
-            if (i >= len) {
-                result[i - len] = poly[0];
-                return;
-            }
-            solve(solve, i * 2, poly);
-            solve(solve, i * 2 + 1, poly);
-        };
-        solve(solve, 1, *this);
-        return result;
+        if (vec.empty()) return {};
+        return _evaluate(_subproduct_tree(vec), *this, vec.size());
     }
 
     // Returns the sum of `a` and `b`.
@@ -165,6 +156,10 @@ template <compatible_modint mint, bool using_ntt = true> struct formal_power_ser
         fps result{f[0].inv()};
         int m = 1;
         int len = f.size();
+        if (_transformable(std::bit_ceil(unsigned(n)))) {
+            std::vector<mint> inv = inv_fps<mint>(std::vector<mint>(f.begin(), f.begin() + std::min(n, len)), n);
+            return fps(inv.begin(), inv.end());
+        }
         while (m < n) {
             m = std::min(m * 2, n);
             fps sub(f.begin(), f.begin() + std::min(m, len));
@@ -354,24 +349,179 @@ template <compatible_modint mint, bool using_ntt = true> struct formal_power_ser
     }
 
     // Given a vector of pairs `{x_i, y_i}`, returns `f` such that `f(x_i) == y_i` for all `i`.
+    // The resulting `fps` has `vec.size()` coefficients.
+    // Reuses the subproduct tree built for evaluating the derivative of `prod (x - x_i)` to combine the partial sums.
     // Requires `vec` to contain distinct `x_i`'s.
     static fps interpolate(const std::vector<std::pair<mint, mint>> &vec) {
-        int m = vec.size(), len = 1;
-        while (len < m) len *= 2;
-        std::vector<fps> nodes(len * 2);
-        for (int i = 0; i < m; i++) nodes[i + len] = {-vec[i].first, 1};
-        for (int i = m; i < len; i++) nodes[i + len] = {1};
-        for (int i = len - 1; i > 0; i--) nodes[i] = nodes[i * 2] * nodes[i * 2 + 1];
-        auto solve = [&](auto &solve, int i, fps poly) -> fps {
-            if (i >= len + m) return {};
-            poly %= nodes[i];
-            if (i >= len) {
-                assert(poly[0] != 0);
-                return {vec[i - len].second / poly[0]};
+        int m = vec.size();
+        if (m == 0) return {};
+        std::vector<mint> points(m);
+        for (int i = 0; i < m; i++) points[i] = vec[i].first;
+        _tree tree = _subproduct_tree(points);
+        int len = tree.len;
+
+        // The root holds `prod (1 - x_i x)`, whose reversal is `prod (x - x_i)`.
+        fps poly(m + 1);
+        for (int i = 0; i <= m; i++) poly[i] = tree.coeffs[tree.levels][m - i];
+        std::vector<mint> weights = _evaluate(tree, derivative(poly), m);
+        std::vector<mint> cur(len), next(len);
+        for (int i = 0; i < m; i++) {
+            assert(weights[i] != 0);
+            cur[i] = vec[i].second / weights[i];
+        }
+
+        // Each node combines the reversed sums `g = g_l * p_r + g_r * p_l` of its children.
+        std::vector<mint> buf;
+        for (int k = 1; k <= tree.levels; k++) {
+            int n = 1 << k, h = n / 2;
+            for (int i = 0; i < len; i += n) {
+                const mint *g_l = cur.data() + i, *g_r = g_l + h;
+                if (tree.cached(k - 1)) {
+                    const ntt_plan<mint> &plan = shared_ntt_plan<mint>(n);
+                    const mint *t_l = tree.trans[k - 1].data() + i * 2, *t_r = t_l + n;
+                    std::span<mint> out(next.data() + i, n);
+                    buf.assign(n, mint{});
+                    std::copy(g_l, g_l + h, buf.begin());
+                    std::fill(std::copy(g_r, g_r + h, out.begin()), out.end(), mint{});
+                    plan.forward(buf);
+                    plan.forward(out);
+                    for (int j = 0; j < n; j++) out[j] = buf[j] * t_r[j] + out[j] * t_l[j];
+                    plan.inverse(out);
+                } else {
+                    const mint *p_l = tree.coeffs[k - 1].data() + i / h * (h + 1), *p_r = p_l + h + 1;
+                    fps prod = fps(g_l, g_l + h) * fps(p_r, p_r + h + 1) + fps(g_r, g_r + h) * fps(p_l, p_l + h + 1);
+                    std::copy(prod.begin(), prod.begin() + n, next.begin() + i);
+                }
+            }
+            cur.swap(next);
+        }
+        fps result(m);
+        for (int i = 0; i < m; i++) result[i] = cur[m - 1 - i];
+        return result;
+    }
+
+  private:
+    // Returns whether products can use number theoretic transforms of length `n` directly.
+    static bool _transformable(int n) {
+        if constexpr (!using_ntt) return false;
+        else return ntt_plan<mint>::supports(n);
+    }
+
+    // The number of points per tree node from which the node's polynomial is kept as a cached transform.
+    static constexpr int _TREE_TRANSFORM_THRESHOLD = 32;
+
+    // A subproduct tree over `len` points, a power of two, padded with `0`'s.
+    // Each node at level `k` covers `2^k` consecutive points and represents `p = prod (1 - x_i x)` of degree at most `2^k`.
+    // Levels below the root whose nodes cover at least `_TREE_TRANSFORM_THRESHOLD` points keep,
+    // for each node, the transform of length `2^(k + 1)` of `p` in `trans[k]`; those are exactly the transforms
+    // its parent multiplies with, so neither evaluation nor interpolation transforms the tree again.
+    // Other levels keep `2^k + 1` coefficients for each node in `coeffs[k]`.
+    struct _tree {
+        int levels, len;
+        bool transform;
+        std::vector<std::vector<mint>> coeffs, trans;
+
+        bool cached(int k) const {
+            return transform && k < levels && (1 << k) >= _TREE_TRANSFORM_THRESHOLD;
+        }
+    };
+
+    // Returns the subproduct tree of `points`.
+    // Requires `!points.empty()`.
+    static _tree _subproduct_tree(const std::vector<mint> &points) {
+        int m = points.size(), len = std::bit_ceil(unsigned(m));
+        int levels = std::countr_zero(unsigned(len));
+        _tree tree{levels, len, _transformable(len), std::vector<std::vector<mint>>(levels + 1), std::vector<std::vector<mint>>(levels + 1)};
+        std::vector<mint> cur(len * 2), lead(len), next;
+        for (int i = 0; i < len; i++) {
+            cur[i * 2] = 1;
+            if (i < m) lead[i] = cur[i * 2 + 1] = -points[i];
+        }
+        for (int k = 0;; k++) {
+            int n = 1 << k;
+            if (tree.cached(k)) {
+                // Keeps the transforms of length `2n` that the parent multiplies.
+                const ntt_plan<mint> &plan = shared_ntt_plan<mint>(n * 2);
+                std::vector<mint> &trans = tree.trans[k];
+                trans.assign(len * 2, mint{});
+                for (int i = 0; i < len; i += n) {
+                    std::span<mint> out(trans.data() + i * 2, n * 2);
+                    std::copy(cur.begin() + i / n * (n + 1), cur.begin() + (i / n + 1) * (n + 1), out.begin());
+                    plan.forward(out);
+                }
+            } else {
+                tree.coeffs[k] = cur;
+            }
+            if (k == levels) break;
+
+            next.assign(len / n / 2 * (n * 2 + 1), mint{});
+            for (int i = 0; i < len; i += n * 2) {
+                mint *out = next.data() + i / n / 2 * (n * 2 + 1);
+                mint lead_l = lead[i / n], lead_r = lead[i / n + 1];
+                lead[i / n / 2] = lead_l * lead_r;
+                if (tree.cached(k)) {
+                    // The product has `2n + 1` coefficients, so the leading one wraps onto the constant term `1`.
+                    const ntt_plan<mint> &plan = shared_ntt_plan<mint>(n * 2);
+                    const mint *t_l = tree.trans[k].data() + i * 2, *t_r = t_l + n * 2;
+                    std::span<mint> prod(out, n * 2);
+                    for (int j = 0; j < n * 2; j++) prod[j] = t_l[j] * t_r[j];
+                    plan.inverse(prod);
+                    out[n * 2] = lead_l * lead_r;
+                    out[0] -= out[n * 2];
+                } else {
+                    const mint *p_l = cur.data() + i / n * (n + 1), *p_r = p_l + n + 1;
+                    fps prod = fps(p_l, p_l + n + 1) * fps(p_r, p_r + n + 1);
+                    std::copy(prod.begin(), prod.end(), out);
+                }
             }
-            return solve(solve, i * 2, poly) * nodes[i * 2 + 1] + solve(solve, i * 2 + 1, poly) * nodes[i * 2];
-        };
-        return solve(solve, 1, fps::derivative(nodes[1]));
+            cur.swap(next);
+        }
+        return tree;
+    }
+
+    // Returns `f(points[i])` for the first `m` points of the subproduct `tree`.
+    // With `p_s = prod (1 - x_i x)` over a node `s`, the node keeps the top `|s|` coefficients of `rev(f) / p_s` modulo `x^n`,
+    // so that each leaf holds `f(x_i)`.
+    // A child's window is the middle product of its parent's window and its sibling's polynomial.
+    static std::vector<mint> _evaluate(const _tree &tree, const fps &f, int m) {
+        int len = tree.len;
+        int n = std::max<int>(f.size(), len);
+        fps rev(n);
+        for (std::size_t i = 0; i < f.size(); i++) rev[n - 1 - i] = f[i];
+        const std::vector<mint> &root = tree.coeffs[tree.levels];
+        rev *= inverse(fps(root.begin(), root.end()), n);
+        std::vector<mint> cur(rev.begin() + n - len, rev.begin() + n), next(len);
+
+        std::vector<mint> buf;
+        for (int k = tree.levels; k >= 1; k--) {
+            int s = 1 << k, h = s / 2;
+            for (int i = 0; i < len; i += s) {
+                const mint *v = cur.data() + i;
+                if (tree.cached(k - 1)) {
+                    // Only the coefficients of degree below `h` wrap around, and those are discarded.
+                    const ntt_plan<mint> &plan = shared_ntt_plan<mint>(s);
+                    const mint *t_l = tree.trans[k - 1].data() + i * 2, *t_r = t_l + s;
+                    std::span<mint> out(next.data() + i, s);
+                    buf.assign(v, v + s);
+                    plan.forward(buf);
+                    for (int j = 0; j < s; j++) out[j] = buf[j] * t_r[j];
+                    plan.inverse(out);
+                    std::copy(out.begin() + h, out.end(), out.begin());
+                    for (int j = 0; j < s; j++) buf[j] *= t_l[j];
+                    plan.inverse(buf);
+                    std::copy(buf.begin() + h, buf.end(), out.begin() + h);
+                } else {
+                    const mint *p_l = tree.coeffs[k - 1].data() + i / h * (h + 1), *p_r = p_l + h + 1;
+                    fps window(v, v + s);
+                    fps prod_l = window * fps(p_r, p_r + h + 1), prod_r = window * fps(p_l, p_l + h + 1);
+                    std::copy(prod_l.begin() + h, prod_l.begin() + s, next.begin() + i);
+                    std::copy(prod_r.begin() + h, prod_r.begin() + s, next.begin() + i + h);
+                }
+            }
+            cur.swap(next);
+        }
+        cur.resize(m);
+        return cur;
     }
 };
 
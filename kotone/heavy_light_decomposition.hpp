@@ -0,0 +1,265 @@
+#ifndef KOTONE_HEAVY_LIGHT_DECOMPOSITION_HPP
+#define KOTONE_HEAVY_LIGHT_DECOMPOSITION_HPP 1
+
+#include <vector>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <cassert>
+#include <kotone/internal_csr>
+
+namespace kotone {
+
+// A heavy-light decomposition of a tree (forest) that maps paths and subtrees to intervals of a single array.
+// Nodes are relabeled so that every heavy path and every subtree occupies a contiguous interval,
+// and any path splits into `O(log n)` such intervals.
+// Pair it with any range structure indexed by `index(v)`, such as `segment_tree`, `sparse_table` or `fenwick_tree`:
+// path queries then cost `O(log n)` range queries, which is `O(log n)` in total with an `O(1)` range structure.
+// The build takes two stack-driven preorders without recursion: the first gives parents and depths,
+// read backwards for subtree sizes and heavy children, and the second pushes each heavy child last
+// so that it is labeled right after its parent.
+struct heavy_light_decomposition {
+  private:
+    int _num_nodes = 0;
+    std::vector<std::pair<int, int>> _edges;
+    std::vector<int> _parent, _depth, _size, _head, _index, _order;
+
+  public:
+    heavy_light_decomposition() {}
+
+    // Constructs a forest of the specified number of nodes and no edges.
+    // Requires `0 <= num_nodes <= 100000000`.
+    heavy_light_decomposition(int num_nodes) : _num_nodes(num_nodes) {
+        assert(0 <= num_nodes && num_nodes <= 100000000);
+    }
+
+    // Returns the number of nodes.
+    int size() const noexcept {
+        return _num_nodes;
+    }
+
+    // Adds an undirected edge between `u` and `v`.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    void add_edge(int u, int v) {
+        assert(0 <= u && u < _num_nodes);
+        assert(0 <= v && v < _num_nodes);
+        _edges.emplace_back(u, v);
+    }
+
+    // Decomposes the forest, rooting the component of `root` at `root`
+    // and every other component at its node with the smallest index.
+    // Must be called after the last `add_edge` and before any query.
+    // Requires the edges to form a forest.
+    // Requires `0 <= root < num_nodes` unless `num_nodes == 0`.
+    void build(int root = 0) {
+        int n = _num_nodes;
+        assert(n == 0 || (0 <= root && root < n));
+        csr_graph graph(n, _edges);
+
+        // Parents, depths and a preorder, then subtree sizes and heavy children in reverse preorder.
+        _parent.assign(n, -1);
+        _depth.assign(n, 0);
+        _size.assign(n, 1);
+        std::vector<int> preorder, stack, heavy(n, -1);
+        std::vector<char> visited(n);
+        preorder.reserve(n);
+        for (int r = 0; r < n; r++) {
+            int s = r == 0 ? root : r == root ? 0 : r;
+            if (visited[s]) continue;
+            visited[s] = true;
+            stack.push_back(s);
+            while (!stack.empty()) {
+                int u = stack.back();
+                stack.pop_back();
+                preorder.push_back(u);
+                for (int j = graph.start[u]; j < graph.start[u + 1]; j++) {
+                    int v = graph.adjacent[j];
+                    if (visited[v]) continue;
+                    visited[v] = true;
+                    _parent[v] = u;
+                    _depth[v] = _depth[u] + 1;
+                    stack.push_back(v);
+                }
+            }
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            int v = preorder[i], p = _parent[v];
+            if (p == -1) continue;
+            _size[p] += _size[v];
+            if (heavy[p] == -1 || _size[v] > _size[heavy[p]]) heavy[p] = v;
+        }
+
+        // Relabels nodes in a preorder that visits each heavy child right after its parent.
+        _head.resize(n);
+        _index.resize(n);
+        _order.resize(n);
+        int next = 0;
+        for (int s : preorder) {
+            if (_parent[s] != -1) continue;
+            _head[s] = s;
+            stack.push_back(s);
+            while (!stack.empty()) {
+                int u = stack.back();
+                stack.pop_back();
+                _index[u] = next;
+                _order[next++] = u;
+                for (int j = graph.start[u]; j < graph.start[u + 1]; j++) {
+                    int v = graph.adjacent[j];
+                    if (v == _parent[u] || v == heavy[u]) continue;
+                    _head[v] = v;
+                    stack.push_back(v);
+                }
+                if (heavy[u] != -1) {
+                    _head[heavy[u]] = _head[u];
+                    stack.push_back(heavy[u]);
+                }
+            }
+        }
+    }
+
+    // Returns the position of `v` in the decomposition order.
+    // Requires `0 <= v < num_nodes`.
+    int index(int v) const {
+        assert(0 <= v && v < _num_nodes);
+        return _index[v];
+    }
+
+    // Returns the node at position `i` in the decomposition order.
+    // Requires `0 <= i < num_nodes`.
+    int node(int i) const {
+        assert(0 <= i && i < _num_nodes);
+        return _order[i];
+    }
+
+    // Returns the parent of `v`, or `-1` if `v` is a root.
+    // Requires `0 <= v < num_nodes`.
+    int parent(int v) const {
+        assert(0 <= v && v < _num_nodes);
+        return _parent[v];
+    }
+
+    // Returns the depth of `v` from the root of its component.
+    // Requires `0 <= v < num_nodes`.
+    int depth(int v) const {
+        assert(0 <= v && v < _num_nodes);
+        return _depth[v];
+    }
+
+    // Returns the topmost node of the heavy path containing `v`.
+    // Requires `0 <= v < num_nodes`.
+    int head(int v) const {
+        assert(0 <= v && v < _num_nodes);
+        return _head[v];
+    }
+
+    // Returns the interval `[l, r)` of positions occupied by the subtree of `v`.
+    // Requires `0 <= v < num_nodes`.
+    std::pair<int, int> subtree(int v) const {
+        assert(0 <= v && v < _num_nodes);
+        return {_index[v], _index[v] + _size[v]};
+    }
+
+    // Returns a copy of `vec` permuted into the decomposition order, so that `result[index(v)] == vec[v]`.
+    // Requires `vec.size() == num_nodes`.
+    template <typename T> std::vector<T> reorder(const std::vector<T> &vec) const {
+        assert(int(vec.size()) == _num_nodes);
+        std::vector<T> result;
+        result.reserve(_num_nodes);
+        for (int v : _order) result.push_back(vec[v]);
+        return result;
+    }
+
+    // Returns the lowest common ancestor of `u` and `v`.
+    // If `u` and `v` are disconnected, returns `-1`.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    int lca(int u, int v) const {
+        assert(0 <= u && u < _num_nodes);
+        assert(0 <= v && v < _num_nodes);
+        while (_head[u] != _head[v]) {
+            if (_index[_head[u]] < _index[_head[v]]) std::swap(u, v);
+            u = _parent[_head[u]];
+            if (u == -1) return -1;
+        }
+        return _index[u] < _index[v] ? u : v;
+    }
+
+    // Returns the number of edges on the path between `u` and `v`.
+    // If `u` and `v` are disconnected, returns `-1`.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    int distance(int u, int v) const {
+        int w = lca(u, v);
+        return w == -1 ? -1 : _depth[u] + _depth[v] - _depth[w] * 2;
+    }
+
+    // Splits the path from `u` to `v` into non-empty intervals and calls `f(l, r, reversed)` for each in order from `u` to `v`.
+    // The positions in `[l, r)` are visited in decreasing order along the path if `reversed`, else in increasing order.
+    // If `edges`, the LCA is excluded, so that each edge is represented by the position of its lower endpoint.
+    // Requires `u` and `v` to be connected.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    template <typename F> void for_each_path(int u, int v, F f, bool edges = false) const {
+        assert(0 <= u && u < _num_nodes);
+        assert(0 <= v && v < _num_nodes);
+        // Intervals on the side of `v` are produced bottom-up, so they are kept until the end.
+        // Each one ends at a light edge, and a path crosses fewer than `32` of those.
+        std::array<std::pair<int, int>, 32> down;
+        int num_down = 0;
+        while (_head[u] != _head[v]) {
+            if (_index[_head[u]] > _index[_head[v]]) {
+                f(_index[_head[u]], _index[u] + 1, true);
+                u = _parent[_head[u]];
+            } else {
+                down[num_down++] = {_index[_head[v]], _index[v] + 1};
+                v = _parent[_head[v]];
+            }
+            assert(u != -1 && v != -1);
+        }
+        if (_index[u] > _index[v]) f(_index[v] + edges, _index[u] + 1, true);
+        else if (_index[u] + edges <= _index[v]) f(_index[u] + edges, _index[v] + 1, false);
+        while (num_down) {
+            auto [l, r] = down[--num_down];
+            f(l, r, false);
+        }
+    }
+
+    // Returns the product of the values on the path from `u` to `v` in order from `u` to `v`.
+    // `prod(l, r)` must return the product over positions `[l, r)` in increasing order,
+    // and `prod_rev(l, r)` the product in decreasing order; for commutative `op` these may be the same function.
+    // If `edges`, the LCA is excluded.
+    // Requires `u` and `v` to be connected.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    template <typename S, S (*op)(S, S), S (*e)(), typename Prod, typename ProdRev>
+    S path_prod(int u, int v, Prod prod, ProdRev prod_rev, bool edges = false) const {
+        S result = e();
+        for_each_path(u, v, [&](int l, int r, bool reversed) {
+            result = op(result, reversed ? prod_rev(l, r) : prod(l, r));
+        }, edges);
+        return result;
+    }
+
+    // Calls `f(l, r)` for each non-empty interval of positions on the path between `u` and `v`, in no particular order.
+    // If `edges`, the LCA is excluded.
+    // Requires `u` and `v` to be connected.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    template <typename F> void path_apply(int u, int v, F f, bool edges = false) const {
+        assert(0 <= u && u < _num_nodes);
+        assert(0 <= v && v < _num_nodes);
+        while (_head[u] != _head[v]) {
+            if (_index[_head[u]] < _index[_head[v]]) std::swap(u, v);
+            f(_index[_head[u]], _index[u] + 1);
+            u = _parent[_head[u]];
+            assert(u != -1);
+        }
+        if (_index[u] > _index[v]) std::swap(u, v);
+        if (_index[u] + edges < _index[v] + 1) f(_index[u] + edges, _index[v] + 1);
+    }
+};
+
+}  // namespace kotone
+
+#endif  // KOTONE_HEAVY_LIGHT_DECOMPOSITION_HPP
@@ -0,0 +1,42 @@
+#ifndef KOTONE_INTERNAL_CSR_HPP
+#define KOTONE_INTERNAL_CSR_HPP 1
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace kotone {
+
+// The adjacency lists of an undirected graph packed into one array in compressed sparse row (CSR) form.
+// The neighbors of `v` are `adjacent[start[v]], ..., adjacent[start[v + 1] - 1]`, in the order their edges were given.
+struct csr_graph {
+    std::vector<int> start, adjacent;
+
+    csr_graph() {}
+
+    // Packs the undirected `edges` between nodes in `[0, num_nodes)`.
+    csr_graph(int num_nodes, const std::vector<std::pair<int, int>> &edges)
+        : start(num_nodes + 1), adjacent(edges.size() * 2) {
+        for (auto [u, v] : edges) {
+            start[u + 1]++;
+            start[v + 1]++;
+        }
+        for (int i = 0; i < num_nodes; i++) start[i + 1] += start[i];
+        std::vector<int> fill(start.begin(), start.end() - 1);
+        for (auto [u, v] : edges) {
+            adjacent[fill[u]++] = v;
+            adjacent[fill[v]++] = u;
+        }
+    }
+
+    // Returns the maximum degree of the nodes, or `0` if there are none.
+    int max_degree() const {
+        int result = 0;
+        for (std::size_t v = 0; v + 1 < start.size(); v++) result = std::max(result, start[v + 1] - start[v]);
+        return result;
+    }
+};
+
+}  // namespace kotone
+
+#endif  // KOTONE_INTERNAL_CSR_HPP
@@ -0,0 +1,54 @@
+#ifndef KOTONE_INTERNAL_PARALLEL_HPP
+#define KOTONE_INTERNAL_PARALLEL_HPP 1
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <bit>
+
+namespace kotone {
+
+// Returns the number of threads used by parallel algorithms in this library.
+int hardware_threads() {
+    static const int result = std::max(1u, std::thread::hardware_concurrency());
+    return result;
+}
+
+// Returns the recursion depth up to which fork-join algorithms should fork,
+// so that the number of leaf tasks is at least `hardware_threads()`.
+int fork_depth() {
+    return std::bit_width(unsigned(hardware_threads() - 1));
+}
+
+// Invokes `f1()` and `f2()`, concurrently if `fork == true`.
+template <typename F1, typename F2> void fork_join(bool fork, F1 &&f1, F2 &&f2) {
+    if (!fork) {
+        f1();
+        f2();
+        return;
+    }
+    std::thread thread(std::forward<F1>(f1));
+    f2();
+    thread.join();
+}
+
+// Returns the number of blocks used by `parallel_for(n, grain, f)`.
+int parallel_blocks(int64_t n, int64_t grain) {
+    return std::clamp<int64_t>(n / grain, 1, hardware_threads());
+}
+
+// Splits `[0, n)` into at most `hardware_threads()` contiguous blocks of length at least `grain`,
+// then invokes `f(block, l, r)` concurrently for each block `[l, r)`.
+// Requires `n >= 0`.
+// Requires `grain > 0`.
+template <typename F> void parallel_for(int64_t n, int64_t grain, F f) {
+    int blocks = parallel_blocks(n, grain);
+    std::vector<std::thread> threads;
+    for (int b = 1; b < blocks; b++) threads.emplace_back(f, b, n * b / blocks, n * (b + 1) / blocks);
+    f(0, 0, n / blocks);
+    for (std::thread &thread : threads) thread.join();
+}
+
+}  // namespace kotone
+
+#endif  // KOTONE_INTERNAL_PARALLEL_HPP
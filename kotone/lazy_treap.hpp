@@ -5,11 +5,23 @@
 #include <utility>
 #include <algorithm>
 #include <cassert>
+#include <type_traits>
 #include <kotone/random>
 #include <kotone/memory_pool>
+#include <kotone/internal_parallel>
 
 namespace kotone {
 
+// Options that remove unused features from the nodes of `lazy_treap_manager`.
+// - `LAZY_TREAP_NO_REVERSE`: disables `reverse()`, so nodes neither store nor maintain reversed products.
+// - `LAZY_TREAP_NO_LAZY`: disables `apply()`, so nodes do not store lazy applications.
+// - `LAZY_TREAP_HASHED_PRIORITY`: derives priorities from a randomized hash of node addresses instead of storing them.
+enum lazy_treap_option {
+    LAZY_TREAP_NO_REVERSE = 1,
+    LAZY_TREAP_NO_LAZY = 2,
+    LAZY_TREAP_HASHED_PRIORITY = 4,
+};
+
 // A self-contained memory manager for implicit treaps with lazy propagation.
 // Requires the following functions:
 // - `S op(S val_l, S val_r)`
@@ -17,21 +29,46 @@ namespace kotone {
 // - `S mapping(F app, S val)`
 // - `F composition(F app_outer, F app_inner)`
 // - `F id()`
+// `options` is a bitwise OR of `lazy_treap_option` values.
 //
 // Reference: https://nyaannyaan.github.io/library/rbst/treap.hpp
-template <typename S, S (*op)(S, S), S (*e)(), typename F, S (*mapping)(F, S), F (*composition)(F, F), F (*id)()>
-struct lazy_treap_manager {
+template <
+    typename S,
+    S (*op)(S, S),
+    S (*e)(),
+    typename F,
+    S (*mapping)(F, S),
+    F (*composition)(F, F),
+    F (*id)(),
+    int options = 0
+> struct lazy_treap_manager {
+  private:
+    static constexpr bool _REVERSIBLE = !(options & LAZY_TREAP_NO_REVERSE);
+    static constexpr bool _LAZY = !(options & LAZY_TREAP_NO_LAZY);
+    static constexpr bool _STORED_PRIORITY = !(options & LAZY_TREAP_HASHED_PRIORITY);
+
+    // A placeholder for disabled node fields that accepts and discards any initializer.
+    template <int> struct _empty {
+        _empty(auto&&...) {}
+    };
+
+    template <bool enabled, typename T, int tag> using _field = std::conditional_t<enabled, T, _empty<tag>>;
+
+  public:
     // A node for treap-related operations.
     struct lazy_treap {
         friend struct lazy_treap_manager;
 
       private:
-        const uint64_t _PRIORITY = randint();
+        [[no_unique_address]] const _field<_STORED_PRIORITY, uint64_t, 0> _PRIORITY = _random_priority();
         lazy_treap *_left = nullptr, *_right = nullptr;
-        S _val = e(), _prod = e(), _prod_rev = e();
-        F _lazy = id();
+        S _val = e(), _prod = e();
+        [[no_unique_address]] _field<_REVERSIBLE, S, 1> _prod_rev = e();
+        [[no_unique_address]] _field<_LAZY, F, 2> _lazy = id();
         int _size = 1;
-        bool _rev = false;
+        [[no_unique_address]] _field<_REVERSIBLE, bool, 3> _rev = false;
+
+        lazy_treap(S val, uint64_t priority) : _PRIORITY(priority), _val(val), _prod(val), _prod_rev(val) {}
 
       public:
         // Constructs a treap node with value initialized to `e()`.
@@ -42,19 +79,41 @@ struct lazy_treap_manager {
     };
 
   private:
+    static constexpr int _PARALLEL_GRAIN = 1 << 16;
+
     memory_pool<lazy_treap> _pool;
+    // Scratch stack for the iterative operations, one per thread so that const operations on disjoint treaps may run concurrently.
+    static inline thread_local std::vector<lazy_treap*> _buffer;
+
+    static auto _random_priority() {
+        if constexpr (_STORED_PRIORITY) return randint();
+        else return _empty<0>{};
+    }
+
+    static uint64_t _priority(const lazy_treap *node) {
+        if constexpr (_STORED_PRIORITY) {
+            return node->_PRIORITY;
+        } else {
+            static const uint64_t SEED = randint();
+            return splitmix64(reinterpret_cast<uintptr_t>(node) ^ SEED);
+        }
+    }
 
     void _push(lazy_treap *node) const {
         if (!node) return;
-        if (node->_rev) {
-            reverse(node->_left);
-            reverse(node->_right);
-            node->_rev = false;
+        if constexpr (_REVERSIBLE) {
+            if (node->_rev) {
+                reverse(node->_left);
+                reverse(node->_right);
+                node->_rev = false;
+            }
         }
-        if (node->_lazy != id()) {
-            apply(node->_left, node->_lazy);
-            apply(node->_right, node->_lazy);
-            node->_lazy = id();
+        if constexpr (_LAZY) {
+            if (node->_lazy != id()) {
+                apply(node->_left, node->_lazy);
+                apply(node->_right, node->_lazy);
+                node->_lazy = id();
+            }
         }
     }
 
@@ -62,24 +121,55 @@ struct lazy_treap_manager {
         if (!node) return;
         _push(node);
         node->_size = 1;
-        node->_prod = node->_prod_rev = node->_val;
+        node->_prod = node->_val;
         if (node->_left) {
             node->_size += node->_left->_size;
             node->_prod = op(node->_left->_prod, node->_prod);
-            node->_prod_rev = op(node->_prod_rev, node->_left->_prod_rev);
         }
         if (node->_right) {
             node->_size += node->_right->_size;
             node->_prod = op(node->_prod, node->_right->_prod);
-            node->_prod_rev = op(node->_right->_prod_rev, node->_prod_rev);
         }
+        if constexpr (_REVERSIBLE) {
+            node->_prod_rev = node->_val;
+            if (node->_left) node->_prod_rev = op(node->_prod_rev, node->_left->_prod_rev);
+            if (node->_right) node->_prod_rev = op(node->_right->_prod_rev, node->_prod_rev);
+        }
+    }
+
+    // Links `count` nodes created by `make_node(i)` into a treap in O(count) time.
+    template <typename G> lazy_treap* _build(int count, G make_node, std::vector<lazy_treap*> &stack) const {
+        stack.clear();
+        for (int i = 0; i < count; i++) {
+            lazy_treap *node = make_node(i);
+            lazy_treap *last = nullptr;
+            while (stack.size() && _priority(stack.back()) < _priority(node)) {
+                last = stack.back();
+                stack.pop_back();
+                _update(last);
+            }
+            node->_left = last;
+            if (stack.size()) stack.back()->_right = node;
+            stack.push_back(node);
+        }
+        while (stack.size() > 1) {
+            _update(stack.back());
+            stack.pop_back();
+        }
+        _update(stack[0]);
+        return stack[0];
     }
 
-    void _init_treap(lazy_treap *root) const {
+    void _to_vector_parallel(lazy_treap *root, S *out, int depth) const {
         if (!root) return;
-        _init_treap(root->_left);
-        _init_treap(root->_right);
-        _update(root);
+        _push(root);
+        int left_size = size(root->_left);
+        out[left_size] = root->_val;
+        fork_join(
+            depth > 0 && size(root) >= _PARALLEL_GRAIN,
+            [&] { _to_vector_parallel(root->_left, out, depth - 1); },
+            [&] { _to_vector_parallel(root->_right, out + left_size + 1, depth - 1); }
+        );
     }
 
     void _to_vector(lazy_treap *root, std::vector<S> &vec) const {
@@ -139,30 +229,42 @@ struct lazy_treap_manager {
     // If `vec` is empty, returns `nullptr`.
     lazy_treap* allocate_treap(const std::vector<S> &vec) {
         if (vec.empty()) return nullptr;
-        std::vector<lazy_treap*> stack;
+        _pool.reserve(vec.size());
+        return _build(vec.size(), [&](int i) { return _pool.allocate(vec[i]); }, _buffer);
+    }
+
+    // Converts the vector to a treap using multiple threads and returns a pointer to the root of the treap.
+    // If `vec` is empty, returns `nullptr`.
+    lazy_treap* allocate_treap_parallel(const std::vector<S> &vec) {
+        if (vec.empty()) return nullptr;
+        int n = vec.size(), blocks = parallel_blocks(n, _PARALLEL_GRAIN);
+        lazy_treap *nodes = _pool.allocate_uninitialized(n);
+        std::vector<uint64_t> seeds(blocks);
+        for (uint64_t &seed : seeds) seed = randint();
+        std::vector<lazy_treap*> roots(blocks);
+        parallel_for(n, _PARALLEL_GRAIN, [&](int b, int64_t l, int64_t r) {
+            std::vector<lazy_treap*> stack;
+            roots[b] = _build(r - l, [&](int i) {
+                return new (nodes + l + i) lazy_treap(vec[l + i], splitmix64(seeds[b] + i));
+            }, stack);
+        });
         lazy_treap *root = nullptr;
-        for (S val : vec) {
-            lazy_treap *node = _pool.allocate(val);
-            lazy_treap *last = nullptr;
-            while (stack.size() && stack.back()->_PRIORITY < node->_PRIORITY) {
-                last = stack.back();
-                stack.pop_back();
-            }
-            node->_left = last;
-            if (stack.size()) stack.back()->_right = node;
-            else root = node;
-            stack.push_back(node);
-        }
-        _init_treap(root);
+        for (lazy_treap *block_root : roots) root = merge(root, block_root);
         return root;
     }
 
     // Frees all memory allocated to nodes in the treap and invalidates their pointers.
     void deallocate_treap(lazy_treap *root) {
         if (!root) return;
-        deallocate_treap(root->_left);
-        deallocate_treap(root->_right);
-        _pool.deallocate(root);
+        std::vector<lazy_treap*> &stack = _buffer;
+        stack.assign(1, root);
+        while (stack.size()) {
+            lazy_treap *node = stack.back();
+            stack.pop_back();
+            if (node->_left) stack.push_back(node->_left);
+            if (node->_right) stack.push_back(node->_right);
+            _pool.deallocate(node);
+        }
     }
 
     // Returns the size of the treap.
@@ -179,24 +281,39 @@ struct lazy_treap_manager {
         return result;
     }
 
+    // Returns a vector containing the values of the treap, using multiple threads for large treaps.
+    std::vector<S> to_vector_parallel(lazy_treap *root) const {
+        std::vector<S> result(size(root), e());
+        _to_vector_parallel(root, result.data(), fork_depth());
+        return result;
+    }
+
     // Merges `root_l` and `root_r`, then returns a pointer to the root of the new treap.
     // This method invalidates `root_l` and `root_r`.
     // Requires `root_l` and `root_r` to be disconnected.
     lazy_treap* merge(lazy_treap *root_l, lazy_treap *root_r) const {
         assert(!root_l || !root_r || root_l != root_r);
-        _push(root_l);
-        _push(root_r);
-        lazy_treap *result;
-        if (!root_l || !root_r) {
-            result = root_l ? root_l : root_r;
-        } else if (root_l->_PRIORITY >= root_r->_PRIORITY) {
-            root_l->_right = merge(root_l->_right, root_r);
-            result = root_l;
-        } else {
-            root_r->_left = merge(root_l, root_r->_left);
-            result = root_r;
+        std::vector<lazy_treap*> &path = _buffer;
+        path.clear();
+        lazy_treap *result = nullptr, **slot = &result;
+        while (root_l && root_r) {
+            if (_priority(root_l) >= _priority(root_r)) {
+                _push(root_l);
+                path.push_back(*slot = root_l);
+                slot = &root_l->_right;
+                root_l = root_l->_right;
+            } else {
+                _push(root_r);
+                path.push_back(*slot = root_r);
+                slot = &root_r->_left;
+                root_r = root_r->_left;
+            }
+        }
+        *slot = root_l ? root_l : root_r;
+        while (path.size()) {
+            _update(path.back());
+            path.pop_back();
         }
-        _update(result);
         return result;
     }
 
@@ -207,20 +324,30 @@ struct lazy_treap_manager {
     // Requires `0 <= index <= size(root)`.
     std::pair<lazy_treap*, lazy_treap*> split(lazy_treap *root, int index) const {
         assert(0 <= index && index <= size(root));
-        if (!root) return {nullptr, nullptr};
-        _push(root);
-        int left_size = size(root->_left);
-        if (index <= left_size) {
-            auto [l, r] = split(root->_left, index);
-            root->_left = r;
-            _update(root);
-            return {l, root};
-        } else {
-            auto [l, r] = split(root->_right, index - left_size - 1);
-            root->_right = l;
-            _update(root);
-            return {root, r};
+        std::vector<lazy_treap*> &path = _buffer;
+        path.clear();
+        lazy_treap *root_l = nullptr, *root_r = nullptr, **slot_l = &root_l, **slot_r = &root_r;
+        while (root) {
+            _push(root);
+            path.push_back(root);
+            int left_size = size(root->_left);
+            if (index <= left_size) {
+                *slot_r = root;
+                slot_r = &root->_left;
+                root = root->_left;
+            } else {
+                *slot_l = root;
+                slot_l = &root->_right;
+                root = root->_right;
+                index -= left_size + 1;
+            }
+        }
+        *slot_l = *slot_r = nullptr;
+        while (path.size()) {
+            _update(path.back());
+            path.pop_back();
         }
+        return {root_l, root_r};
     }
 
     // Returns the product of the treap.
@@ -231,6 +358,18 @@ struct lazy_treap_manager {
         return e();
     }
 
+    // Returns the product of the concatenation of the treaps, using multiple threads for many treaps.
+    // Requires the treaps to be pairwise disconnected.
+    S get_prod_parallel(const std::vector<lazy_treap*> &roots) const {
+        std::vector<S> prods(parallel_blocks(roots.size(), _PARALLEL_GRAIN), e());
+        parallel_for(roots.size(), _PARALLEL_GRAIN, [&](int b, int64_t l, int64_t r) {
+            for (int64_t i = l; i < r; i++) prods[b] = op(prods[b], get_prod(roots[i]));
+        });
+        S result = e();
+        for (const S &prod : prods) result = op(result, prod);
+        return result;
+    }
+
     // Returns the product of the interval `[l, r)` in the treap.
     // Requires `0 <= l <= r <= size(root)`.
     S get_prod(lazy_treap *&root, int l, int r) const {
@@ -264,6 +403,7 @@ struct lazy_treap_manager {
         auto [nl, nml] = split(root, index);
         auto [nmr, nr] = split(nml, 1);
         nmr->_val = val;
+        _update(nmr);
         root = merge(merge(nl, nmr), nr);
     }
 
@@ -299,6 +439,7 @@ struct lazy_treap_manager {
 
     // Reverses the entire treap.
     void reverse(lazy_treap *root) const {
+        static_assert(_REVERSIBLE, "reverse() is disabled by LAZY_TREAP_NO_REVERSE");
         if (!root) return;
         std::swap(root->_left, root->_right);
         std::swap(root->_prod, root->_prod_rev);
@@ -308,6 +449,7 @@ struct lazy_treap_manager {
     // Reverses the specified interval `[l, r)` in the treap.
     // Requires `0 <= l <= r <= size(root)`.
     void reverse(lazy_treap *&root, int l, int r) const {
+        static_assert(_REVERSIBLE, "reverse() is disabled by LAZY_TREAP_NO_REVERSE");
         assert(0 <= l && l <= r && r <= size(root));
         if (l == r) return;
         auto [nl, nml] = split(root, l);
@@ -318,16 +460,18 @@ struct lazy_treap_manager {
 
     // Transforms the entire treap under the specified application.
     void apply(lazy_treap *root, F app) const {
+        static_assert(_LAZY, "apply() is disabled by LAZY_TREAP_NO_LAZY");
         if (!root) return;
         root->_lazy = composition(app, root->_lazy);
         root->_val = mapping(app, root->_val);
         root->_prod = mapping(app, root->_prod);
-        root->_prod_rev = mapping(app, root->_prod_rev);
+        if constexpr (_REVERSIBLE) root->_prod_rev = mapping(app, root->_prod_rev);
     }
 
     // Transforms interval `[l, r)` in the treap under the specified application.
     // Requires `0 <= l <= r <= size(root)`.
     void apply(lazy_treap *&root, F app, int l, int r) const {
+        static_assert(_LAZY, "apply() is disabled by LAZY_TREAP_NO_LAZY");
         assert(0 <= l && l <= r && r <= size(root));
         if (l == r) return;
         auto [nl, nml] = split(root, l);
@@ -2,59 +2,162 @@
 #define KOTONE_LCA_HPP 1
 
 #include <vector>
+#include <utility>
+#include <span>
 #include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <cassert>
+#include <kotone/internal_csr>
 #include <kotone/dsu>
 
 namespace kotone {
 
 // A data structure that manages the lowest common ancestors (LCA) of nodes in a tree (forest).
+// The preorder, depths and parents come from an explicit stack rather than recursion, so deep trees are safe.
+// For `u != v` with `u` visited first, the LCA is the parent of the shallowest node visited in `(u, v]`,
+// which is also the parent with the smallest preorder index among those nodes.
+// Range minima over the preorder are answered in `O(1)` by a sparse table over blocks of `64`
+// and, within a block, by a bitmask of the monotonic stack at each position, using `O(n)` words in total.
+// Level ancestors use the ladder algorithm over a long-path decomposition,
+// with jump pointers stored only for leaves; these tables are built on the first such query.
 struct lca_tree {
   private:
     int _num_nodes = 0;
-    std::vector<std::vector<int>> _tree, _sparse_table;
-    std::vector<int> _depth, _euler, _level, _first, _log, _is_root;
+    std::vector<std::pair<int, int>> _edges;
+    std::vector<int> _depth, _index, _order, _up, _is_root, _sparse_table;
+    std::vector<uint64_t> _mask;
+    std::vector<int> _leaf, _ladder, _ladder_pos, _jump, _jump_start;
     dsu<int> _dsu;
     bool _requires_build = false;
+    bool _requires_ladders = false;
     bool _is_rooted = true;
 
-    void _euler_tour(int u, int p, int d) {
-        _depth[u] = d;
-        _first[u] = _euler.size();
-        _euler.push_back(u);
-        _level.push_back(d);
-        for (int v : _tree[u]) {
-            if (v == p) continue;
-            _euler_tour(v, u, d + 1);
-            _euler.push_back(u);
-            _level.push_back(d);
+    void _dfs_order() {
+        int n = _num_nodes;
+        csr_graph graph(n, _edges);
+        _index.assign(n, -1);
+        _order.resize(n);
+        _up.resize(n);
+        std::vector<int> stack, parent(n, -1);
+        int visited = 0;
+        for (int i = 0; i < n; i++) {
+            if (!((_is_rooted && _is_root[i]) || (!_is_rooted && i == _dsu.leader(i)))) continue;
+            _depth[i] = 0;
+            stack.push_back(i);
+            while (!stack.empty()) {
+                int u = stack.back();
+                stack.pop_back();
+                _index[u] = visited;
+                _order[visited] = u;
+                _up[visited++] = parent[u] == -1 ? _index[u] : _index[parent[u]];
+                for (int j = graph.start[u]; j < graph.start[u + 1]; j++) {
+                    int v = graph.adjacent[j];
+                    if (v == parent[u]) continue;
+                    parent[v] = u;
+                    _depth[v] = _depth[u] + 1;
+                    stack.push_back(v);
+                }
+            }
         }
     }
 
     void _build() {
         if (!_requires_build) return;
         _requires_build = false;
-        _euler.clear();
-        _level.clear();
-        for (int i = 0; i < _num_nodes; i++) {
-            if (
-                (_is_rooted && _is_root[i])
-                || (!_is_rooted && i == _dsu.leader(i))
-            ) _euler_tour(i, -1, 0);
+        _dfs_order();
+        int n = _num_nodes, blocks = (n + 63) / 64;
+        _mask.resize(n);
+        std::vector<int> block_min(blocks);
+        for (int b = 0; b < blocks; b++) {
+            uint64_t stack = 0;
+            int l = b * 64, r = std::min(n, l + 64);
+            for (int i = l; i < r; i++) {
+                while (stack && _up[l + 63 - std::countl_zero(stack)] > _up[i]) {
+                    stack ^= uint64_t(1) << (63 - std::countl_zero(stack));
+                }
+                stack |= uint64_t(1) << (i - l);
+                _mask[i] = stack;
+            }
+            block_min[b] = _up[l + std::countr_zero(stack)];
         }
-        int M = _euler.size();
-        _log.resize(M + 1);
-        for (int i = 2; i <= M; i++) _log[i] = _log[i / 2] + 1;
-        int K = _log[M] + 1;
-        _sparse_table.assign(K, std::vector<int>(M));
-        for (int i = 0; i < M; i++) _sparse_table[0][i] = i;
+        int K = std::bit_width(unsigned(blocks));
+        _sparse_table.resize(std::size_t(K) * blocks);
+        std::copy(block_min.begin(), block_min.end(), _sparse_table.begin());
         for (int k = 1; k < K; k++) {
-            for (int i = 0; i + (1 << k) <= M; i++) {
-                int x = _sparse_table[k - 1][i];
-                int y = _sparse_table[k - 1][i + (1 << (k - 1))];
-                _sparse_table[k][i] = _level[x] < _level[y] ? x : y;
+            int *prev = _sparse_table.data() + std::size_t(k - 1) * blocks, *cur = prev + blocks;
+            for (int i = 0; i + (1 << k) <= blocks; i++) cur[i] = std::min(prev[i], prev[i + (1 << (k - 1))]);
+        }
+    }
+
+    // Returns the minimum of `_up` over `[l, r]` within a single block.
+    int _block_min(int l, int r) const {
+        return _up[(r & ~63) + std::countr_zero(_mask[r] & (~uint64_t(0) << (l & 63)))];
+    }
+
+    // Returns the minimum of `_up` over `[l, r]`.
+    int _range_min(int l, int r) const {
+        int bl = l >> 6, br = r >> 6;
+        if (bl == br) return _block_min(l, r);
+        int result = std::min(_block_min(l, bl * 64 + 63), _block_min(br * 64, r));
+        if (bl + 1 < br) {
+            int k = std::bit_width(unsigned(br - bl - 1)) - 1, blocks = (_num_nodes + 63) / 64;
+            const int *row = _sparse_table.data() + std::size_t(k) * blocks;
+            result = std::min({result, row[bl + 1], row[br - (1 << k)]});
+        }
+        return result;
+    }
+
+    // Returns the parent of `v`, or `-1` if `v` is a root.
+    int _parent(int v) const {
+        int i = _index[v];
+        return _up[i] == i ? -1 : _order[_up[i]];
+    }
+
+    void _build_ladders() {
+        if (_requires_build) _build();
+        if (!_requires_ladders) return;
+        _requires_ladders = false;
+        int n = _num_nodes;
+        std::vector<int> height(n), long_child(n, -1);
+        _leaf.resize(n);
+        for (int i = n - 1; i >= 0; i--) {
+            int v = _order[i], p = _parent(v);
+            _leaf[v] = long_child[v] == -1 ? v : _leaf[long_child[v]];
+            if (p != -1 && height[v] + 1 > height[p]) {
+                height[p] = height[v] + 1;
+                long_child[p] = v;
             }
         }
+
+        // Each long path of `len` nodes is stored from bottom to top, followed by up to `len` further ancestors.
+        _ladder.clear();
+        _ladder.reserve(std::size_t(n) * 2);
+        _ladder_pos.resize(n);
+        for (int i = 0; i < n; i++) {
+            int t = _order[i], p = _parent(t);
+            if (p != -1 && long_child[p] == t) continue;
+            int len = height[t] + 1, base = _ladder.size();
+            _ladder.resize(base + len);
+            for (int v = t, d = len - 1; v != -1; v = long_child[v], d--) {
+                _ladder[base + d] = v;
+                _ladder_pos[v] = base + d;
+            }
+            for (int j = 0; j < len && p != -1; j++, p = _parent(p)) _ladder.push_back(p);
+        }
+
+        // Each leaf stores its ancestors at distances `1, 2, 4, ...`.
+        _jump.clear();
+        _jump_start.resize(n);
+        std::vector<int> path;
+        for (int i = 0; i < n; i++) {
+            int v = _order[i], d = _depth[v];
+            path.resize(d + 1);
+            path[d] = v;
+            if (long_child[v] != -1) continue;
+            _jump_start[v] = _jump.size();
+            for (int j = 1; j <= d; j *= 2) _jump.push_back(path[d - j]);
+        }
     }
 
   public:
@@ -63,10 +166,9 @@ struct lca_tree {
     // Constructs a tree for the specified number of nodes.
     lca_tree(int num_nodes) : _num_nodes(num_nodes), _dsu(num_nodes) {
         assert(0 <= num_nodes && num_nodes <= 100000000);
-        _tree.resize(num_nodes);
         _depth.resize(num_nodes);
-        _first.resize(num_nodes);
         _is_root.resize(num_nodes, 1);
+        _requires_build = _requires_ladders = true;
     }
 
     // Returns the number of nodes in the tree.
@@ -86,11 +188,11 @@ struct lca_tree {
         assert(0 <= child && child < _num_nodes);
         assert(!_dsu.connected(parent, child));
         if (!_is_root[child]) _is_rooted = false;
-        _tree[parent].push_back(child);
-        _tree[child].push_back(parent);
+        _edges.emplace_back(parent, child);
         _dsu.merge(parent, child);
         _is_root[child] = false;
         _requires_build = true;
+        _requires_ladders = true;
     }
 
     // Prompts the tree to build the LCA table immediately.
@@ -110,12 +212,85 @@ struct lca_tree {
         if (_requires_build) _build();
         if (u == v) return u;
         if (!_dsu.connected(u, v)) return -1;
-        int L = _first[u], R = _first[v];
+        int L = _index[u], R = _index[v];
         if (L > R) std::swap(L, R);
-        int k = _log[R - L + 1];
-        int x = _sparse_table[k][L];
-        int y = _sparse_table[k][R - (1 << k) + 1];
-        return _level[x] < _level[y] ? _euler[x] : _euler[y];
+        return _order[_range_min(L + 1, R)];
+    }
+
+    // Returns the lowest common ancestor of each pair in `queries`, as `get_lca` does.
+    // Answers all pairs in one pass over the preorder with Tarjan's offline algorithm,
+    // so the cost is dominated by sequential scans rather than one table lookup per pair.
+    // Requires every node in `queries` to be in `[0, num_nodes)`.
+    std::vector<int> get_lca_batch(std::span<const std::pair<int, int>> queries) {
+        if (_requires_build) _build();
+        int n = _num_nodes, q = queries.size();
+        std::vector<int> result(q, -1), start(n + 1), bucket(q);
+        for (auto [u, v] : queries) {
+            assert(0 <= u && u < n);
+            assert(0 <= v && v < n);
+            start[std::max(_index[u], _index[v]) + 1]++;
+        }
+        for (int i = 0; i < n; i++) start[i + 1] += start[i];
+        std::vector<int> fill(start.begin(), start.end() - 1);
+        for (int i = 0; i < q; i++) {
+            auto [u, v] = queries[i];
+            bucket[fill[std::max(_index[u], _index[v])]++] = i;
+        }
+
+        // Nodes on the stack are the current root path; a node is merged into its parent once its subtree is done,
+        // so `ancestor[leader(w)]` is the deepest node on the root path above `w`.
+        dsu<int> finished(n);
+        std::vector<int> ancestor(n), stack;
+        int tree_start = 0;
+        for (int i = 0; i < n; i++) {
+            int v = _order[i], p = _parent(v);
+            if (p == -1) tree_start = i;
+            while (!stack.empty() && stack.back() != p) {
+                int w = stack.back();
+                stack.pop_back();
+                int x = _parent(w);
+                if (x != -1) ancestor[finished.merge(w, x)] = x;
+            }
+            stack.push_back(v);
+            ancestor[v] = v;
+            for (int j = start[i]; j < start[i + 1]; j++) {
+                auto [a, b] = queries[bucket[j]];
+                int w = a == v ? b : a;
+                if (_index[w] >= tree_start) result[bucket[j]] = ancestor[finished.leader(w)];
+            }
+        }
+        return result;
+    }
+
+    // Returns the ancestor of `v` that is `k` edges above it.
+    // If `k` exceeds the depth of `v`, returns `-1`.
+    // If the tree is undirected due to the effect of `add_edge`, depths are measured from the node chosen as the root.
+    // Requires `0 <= v < num_nodes`.
+    // Requires `k >= 0`.
+    int level_ancestor(int v, int k) {
+        assert(0 <= v && v < _num_nodes);
+        assert(k >= 0);
+        _build_ladders();
+        if (k > _depth[v]) return -1;
+        if (k == 0) return v;
+        int leaf = _leaf[v], d = k + _depth[leaf] - _depth[v];
+        int j = std::bit_width(unsigned(d)) - 1;
+        int u = _jump[_jump_start[leaf] + j];
+        return _ladder[_ladder_pos[u] + d - (1 << j)];
+    }
+
+    // Returns the node that is `k` edges away from `u` on the path from `u` to `v`.
+    // If `u` and `v` are disconnected, or `k` exceeds their distance, returns `-1`.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    // Requires `k >= 0`.
+    int jump(int u, int v, int k) {
+        assert(k >= 0);
+        int w = get_lca(u, v);
+        if (w == -1) return -1;
+        int du = _depth[u] - _depth[w], dist = du + _depth[v] - _depth[w];
+        if (k > dist) return -1;
+        return k <= du ? level_ancestor(u, k) : level_ancestor(v, dist - k);
     }
 
     // Returns the distance between nodes `u` and `v`.
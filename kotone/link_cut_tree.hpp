@@ -2,6 +2,9 @@
 #define KOTONE_LINK_CUT_TREE_HPP 1
 
 #include <vector>
+#include <span>
+#include <utility>
+#include <concepts>
 #include <cassert>
 
 namespace kotone {
@@ -11,15 +14,25 @@ namespace kotone {
 // - `void on_update(int parent, int left, int right)`
 // - `void on_reverse(int parent, int left, int right)`
 // - `void on_push(int parent, int left, int right)`
+// - `void on_virtual(int parent, int child, bool attach)`
+//
+// `on_virtual` is called whenever the splay tree rooted at `child` becomes (`attach == true`)
+// or stops being (`attach == false`) a virtual child of `parent`, before `parent` is updated.
+// Maintaining an aggregate of virtual children per vertex and folding it into `on_update` enables subtree queries:
+// after `reorient(r)` and `access(v)`, the subtree of `v` consists of `v` and its virtual children.
 //
 // Reference: https://usaco.guide/adv/link-cut-tree
 // Reference: https://nyaannyaan.github.io/library/lct/link-cut-base.hpp
 template <
     void (*on_update)(int, int, int) = nullptr,
     void (*on_reverse)(int, int, int) = nullptr,
-    void (*on_push)(int, int, int) = nullptr
+    void (*on_push)(int, int, int) = nullptr,
+    void (*on_virtual)(int, int, bool) = nullptr
 > struct link_cut_tree {
   private:
+    // Tested once here, since testing the address of a function in a condition triggers `-Waddress`.
+    static constexpr bool _HAS_ON_VIRTUAL = on_virtual != nullptr;
+
     struct splay_vertex {
         int parent = -1, left = -1, right = -1, size = 1;
         bool rev = false;
@@ -102,6 +115,10 @@ template <
         int p = v, c = -1;
         while (p != -1) {
             _splay(p);
+            if constexpr (_HAS_ON_VIRTUAL) {
+                if (_vec[p].right != -1) on_virtual(p, _vec[p].right, true);
+                if (c != -1) on_virtual(p, c, false);
+            }
             _vec[p].right = c;
             _update(p);
             c = p;
@@ -112,15 +129,20 @@ template <
 
     // Returns the level ancestor of `v` at depth `d`.
     int _jump(int v, int d) {
-        _push(v);
-        int l = _vec[v].left;
-        int dv = l == -1 ? 0 : _vec[l].size;
-        if (d == dv) {
-            _splay(v);
-            return v;
+        while (true) {
+            _push(v);
+            int l = _vec[v].left;
+            int dv = l == -1 ? 0 : _vec[l].size;
+            if (d == dv) break;
+            if (d < dv) {
+                v = l;
+            } else {
+                v = _vec[v].right;
+                d -= dv + 1;
+            }
         }
-        if (d < dv) return _jump(l, d);
-        return _jump(_vec[v].right, d - dv - 1);
+        _splay(v);
+        return v;
     }
 
   public:
@@ -190,6 +212,319 @@ template <
         assert(v != root(p));
         _access(p);
         _vec[v].parent = p;
+        if constexpr (_HAS_ON_VIRTUAL) {
+            on_virtual(p, v, true);
+            _update(p);
+        }
+    }
+
+    // Calls `link(v, p)` for each pair `(v, p)` in `edges` in order.
+    // Requires each pair to satisfy the requirements of `link` at the time it is linked.
+    void link_batch(std::span<const std::pair<int, int>> edges) {
+        for (auto [v, p] : edges) link(v, p);
+    }
+
+    // Calls `cut(v)` for each vertex `v` in `vertices` in order.
+    // Requires each vertex to satisfy the requirements of `cut` at the time it is cut.
+    void cut_batch(std::span<const int> vertices) {
+        for (int v : vertices) cut(v);
+    }
+
+    // Reorients the tree containing `v` such that `v` becomes the new root.
+    // Requires `0 <= v < num_vertices`.
+    void reorient(int v) {
+        assert(0 <= v && v < _len);
+        _access(v);
+        _reverse(v);
+        _access(v);
+    }
+
+    // Returns the lowest common ancestor of `u` and `v`.
+    // If `u` and `v` are disconnected, returns `-1`.
+    // Requires `0 <= u < num_vertices`.
+    // Requires `0 <= v < num_vertices`.
+    int lca(int u, int v) {
+        assert(0 <= u && u < _len);
+        assert(0 <= v && v < _len);
+        if (u == v) return u;
+        _access(u);
+        _access(v);
+        if (_vec[u].parent == -1) return -1;
+        _splay(u);
+        if (_vec[u].parent == -1) return u;
+        return _vec[u].parent;
+    }
+
+    // Returns the number of edges between `v` and its root.
+    // Requires `0 <= v < num_vertices`.
+    int depth(int v) {
+        assert(0 <= v && v < _len);
+        _access(v);
+        if (int l = _vec[v].left; l == -1) return 0;
+        else return _vec[l].size;
+    }
+
+    // Returns the level ancestor of `v` at depth `d` relative to the root.
+    // If the level ancestor does not exist, returns `-1`.
+    // Requires `0 <= v < num_vertices`.
+    // Requires `d >= 0`.
+    int level_ancestor(int v, int d) {
+        assert(0 <= v && v < _len);
+        assert(d >= 0);
+        if (d > depth(v)) return -1;
+        return _jump(v, d);
+    }
+};
+
+// A link-cut tree that maintains path products of a monoid with lazy path updates, given as template functions.
+// Unlike `link_cut_tree`, the aggregates live in the same node as the links, so a rotation touches one node per vertex,
+// and the monoid operations can be inlined.
+// The product of the reversed path is kept alongside, so `op` need not be commutative.
+// `mapping(f, x)` must distribute over `op`, as for a lazy segment tree.
+template <
+    typename S,
+    S (*op)(S, S),
+    S (*e)(),
+    typename F,
+    S (*mapping)(F, S),
+    F (*composition)(F, F),
+    F (*id)()
+> struct lazy_link_cut_tree {
+  private:
+    struct splay_vertex {
+        int parent = -1, left = -1, right = -1, size = 1;
+        bool rev = false;
+        S val = e(), prod = e(), prod_rev = e();
+        F lazy = id();
+    };
+    std::vector<splay_vertex> _vec;
+    int _len = 0;
+
+    void _update(int v) {
+        splay_vertex &x = _vec[v];
+        x.size = 1;
+        x.prod = x.prod_rev = x.val;
+        if (x.left != -1) {
+            const splay_vertex &l = _vec[x.left];
+            x.size += l.size;
+            x.prod = op(l.prod, x.prod);
+            x.prod_rev = op(x.prod_rev, l.prod_rev);
+        }
+        if (x.right != -1) {
+            const splay_vertex &r = _vec[x.right];
+            x.size += r.size;
+            x.prod = op(x.prod, r.prod);
+            x.prod_rev = op(r.prod_rev, x.prod_rev);
+        }
+    }
+
+    void _apply(int v, F f) {
+        splay_vertex &x = _vec[v];
+        x.val = mapping(f, x.val);
+        x.prod = mapping(f, x.prod);
+        x.prod_rev = mapping(f, x.prod_rev);
+        x.lazy = composition(f, x.lazy);
+    }
+
+    void _reverse(int v) {
+        splay_vertex &x = _vec[v];
+        std::swap(x.left, x.right);
+        std::swap(x.prod, x.prod_rev);
+        x.rev ^= true;
+    }
+
+    void _push(int v) {
+        int l = _vec[v].left, r = _vec[v].right;
+        if (_vec[v].rev) {
+            if (l != -1) _reverse(l);
+            if (r != -1) _reverse(r);
+            _vec[v].rev = false;
+        }
+        F f = _vec[v].lazy;
+        if constexpr (std::equality_comparable<F>) {
+            if (f == id()) return;
+        }
+        if (l != -1) _apply(l, f);
+        if (r != -1) _apply(r, f);
+        _vec[v].lazy = id();
+    }
+
+    int _dir(int v) const noexcept {
+        int p = _vec[v].parent;
+        if (p == -1) return -2;
+        if (v == _vec[p].left) return 0;
+        if (v == _vec[p].right) return 1;
+        return -1;
+    }
+
+    void _merge(int p, int c, int d) noexcept {
+        if (d == 0) _vec[p].left = c;
+        else if (d == 1) _vec[p].right = c;
+        if (c != -1) _vec[c].parent = p;
+    }
+
+    void _rotate(int v) {
+        int d = _dir(v);
+        int p = _vec[v].parent;
+        _merge(_vec[p].parent, v, _dir(p));
+        if (d == 0) _merge(p, _vec[v].right, 0);
+        else _merge(p, _vec[v].left, 1);
+        _merge(v, p, 1 - d);
+        _update(p);
+    }
+
+    void _splay(int v) {
+        while (_dir(v) >= 0 && _dir(_vec[v].parent) >= 0) {
+            _push(_vec[_vec[v].parent].parent);
+            _push(_vec[v].parent);
+            _push(v);
+            if (_dir(v) == _dir(_vec[v].parent)) _rotate(_vec[v].parent);
+            else _rotate(v);
+            _rotate(v);
+        }
+        if (_dir(v) >= 0) {
+            _push(_vec[v].parent);
+            _push(v);
+            _rotate(v);
+        }
+        _push(v);
+        _update(v);
+    }
+
+    void _access(int v) {
+        int p = v, c = -1;
+        while (p != -1) {
+            _splay(p);
+            _vec[p].right = c;
+            _update(p);
+            c = p;
+            p = _vec[p].parent;
+        }
+        _splay(v);
+    }
+
+    int _jump(int v, int d) {
+        while (true) {
+            _push(v);
+            int l = _vec[v].left;
+            int dv = l == -1 ? 0 : _vec[l].size;
+            if (d == dv) break;
+            if (d < dv) {
+                v = l;
+            } else {
+                v = _vec[v].right;
+                d -= dv + 1;
+            }
+        }
+        _splay(v);
+        return v;
+    }
+
+  public:
+    lazy_link_cut_tree() {}
+
+    // Initializes a link-cut tree with the specified number of isolated vertices, each valued `e()`.
+    // Requires `num_vertices >= 0`.
+    lazy_link_cut_tree(int num_vertices) : _len(num_vertices) {
+        assert(num_vertices >= 0);
+        _vec.resize(_len);
+    }
+
+    // Initializes a link-cut tree with isolated vertices valued `vec`.
+    lazy_link_cut_tree(const std::vector<S> &vec) : _len(vec.size()) {
+        _vec.resize(_len);
+        for (int v = 0; v < _len; v++) _vec[v].val = _vec[v].prod = _vec[v].prod_rev = vec[v];
+    }
+
+    // Returns the value of `v`.
+    // Requires `0 <= v < num_vertices`.
+    S get(int v) {
+        assert(0 <= v && v < _len);
+        _access(v);
+        return _vec[v].val;
+    }
+
+    // Sets the value of `v` to `val`.
+    // Requires `0 <= v < num_vertices`.
+    void set(int v, S val) {
+        assert(0 <= v && v < _len);
+        _access(v);
+        _vec[v].val = val;
+        _update(v);
+    }
+
+    // Returns the product of the values on the path from `u` to `v`, in order from `u` to `v`.
+    // Makes `u` the root of its tree.
+    // Requires `0 <= u < num_vertices`.
+    // Requires `0 <= v < num_vertices`.
+    // Requires `u` and `v` to be connected.
+    S prod(int u, int v) {
+        reorient(u);
+        _access(v);
+        return _vec[v].prod;
+    }
+
+    // Applies `f` to the values on the path between `u` and `v`.
+    // Makes `u` the root of its tree.
+    // Requires `0 <= u < num_vertices`.
+    // Requires `0 <= v < num_vertices`.
+    // Requires `u` and `v` to be connected.
+    void apply(int u, int v, F f) {
+        reorient(u);
+        _access(v);
+        _apply(v, f);
+    }
+
+    // Returns the root of the tree containing `v`.
+    // Requires `0 <= v < num_vertices`.
+    int root(int v) {
+        assert(0 <= v && v < _len);
+        _access(v);
+        while (_vec[v].left != -1) {
+            v = _vec[v].left;
+            _push(v);
+        }
+        _splay(v);
+        return v;
+    }
+
+    // Removes the edge between `v` and its parent.
+    // Requires `0 <= v < num_vertices`.
+    // Requires the parent to exist.
+    void cut(int v) {
+        assert(0 <= v && v < _len);
+        _access(v);
+        assert(_vec[v].left != -1);
+        _vec[_vec[v].left].parent = -1;
+        _vec[v].left = -1;
+        _update(v);
+    }
+
+    // Adds `p` as the parent of `v`.
+    // Requires `0 <= v < num_vertices`.
+    // Requires `0 <= p < num_vertices`.
+    // Requires `v` to be the root of a tree.
+    // Requires `v` and `p` to be disconnected.
+    void link(int v, int p) {
+        assert(0 <= v && v < _len);
+        assert(0 <= p && p < _len);
+        _access(v);
+        assert(_vec[v].left == -1);
+        assert(v != root(p));
+        _access(p);
+        _vec[v].parent = p;
+    }
+
+    // Calls `link(v, p)` for each pair `(v, p)` in `edges` in order.
+    // Requires each pair to satisfy the requirements of `link` at the time it is linked.
+    void link_batch(std::span<const std::pair<int, int>> edges) {
+        for (auto [v, p] : edges) link(v, p);
+    }
+
+    // Calls `cut(v)` for each vertex `v` in `vertices` in order.
+    // Requires each vertex to satisfy the requirements of `cut` at the time it is cut.
+    void cut_batch(std::span<const int> vertices) {
+        for (int v : vertices) cut(v);
     }
 
     // Reorients the tree containing `v` such that `v` becomes the new root.
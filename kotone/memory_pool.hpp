@@ -15,14 +15,15 @@ template <typename T> struct memory_pool {
     };
 
     static constexpr int _DEFAULT_CHUNK_SIZE = 8;
-    int _chunk_size;
+    int _chunk_size, _num_free = 0;
     std::vector<T*> _chunks;
     block *_free_list = nullptr;
 
-    void _allocate_chunk() {
-        T *chunk = static_cast<T*>(::operator new(sizeof(T) * _chunk_size));
+    void _allocate_chunk(int count) {
+        T *chunk = static_cast<T*>(::operator new(sizeof(T) * count));
         _chunks.push_back(chunk);
-        for (int i = 0; i < _chunk_size; i++) {
+        _num_free += count;
+        for (int i = count - 1; i >= 0; i--) {
             block *b = reinterpret_cast<block*>(chunk + i);
             b->_next = _free_list;
             _free_list = b;
@@ -46,6 +47,7 @@ template <typename T> struct memory_pool {
     // Exchanges the content of the two memory pools.
     void swap(memory_pool &other) noexcept {
         std::swap(_chunk_size, other._chunk_size);
+        std::swap(_num_free, other._num_free);
         std::swap(_chunks, other._chunks);
         std::swap(_free_list, other._free_list);
     }
@@ -56,11 +58,30 @@ template <typename T> struct memory_pool {
         _chunk_size = chunk_size;
     }
 
+    // Ensures room for `count` more objects without further allocation.
+    // Only the shortfall beyond the freed objects is allocated, as a single chunk that the next allocations use first.
+    // Requires `count >= 0`.
+    void reserve(int count) {
+        assert(count >= 0);
+        if (count > _num_free) _allocate_chunk(count - _num_free);
+    }
+
+    // Allocates a contiguous array of `count` uninitialized objects and returns a pointer to its first element.
+    // Each object must be constructed in place before use and may be freed individually by `deallocate()`.
+    // Requires `count > 0`.
+    T* allocate_uninitialized(int count) {
+        assert(count > 0);
+        T *chunk = static_cast<T*>(::operator new(sizeof(T) * count));
+        _chunks.push_back(chunk);
+        return chunk;
+    }
+
     // Allocates memory and constructs the given object in place using args.
     template <typename ...Args> T* allocate(Args &&...args) {
-        if (!_free_list) _allocate_chunk();
+        if (!_free_list) _allocate_chunk(_chunk_size);
         block *b = _free_list;
         _free_list = b->_next;
+        _num_free--;
         T *obj = reinterpret_cast<T*>(b);
         new (obj) T(std::forward<Args>(args)...);
         return obj;
@@ -72,6 +93,7 @@ template <typename T> struct memory_pool {
         block *b = reinterpret_cast<block*>(obj);
         b->_next = _free_list;
         _free_list = b;
+        _num_free++;
     }
 
     // Frees all allocated memory in the memory pool.
@@ -80,6 +102,7 @@ template <typename T> struct memory_pool {
         for (T *chunk : _chunks) ::operator delete(chunk);
         _chunks.clear();
         _free_list = nullptr;
+        _num_free = 0;
     }
 
     // Frees all allocated memory and destroys the memory pool.
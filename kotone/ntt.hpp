@@ -0,0 +1,416 @@
+#ifndef KOTONE_NTT_HPP
+#define KOTONE_NTT_HPP 1
+
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <atcoder/modint>
+#include <kotone/prime>
+#include <kotone/internal_parallel>
+#include <kotone/internal_type_traits>
+
+namespace kotone {
+
+// Adds the convolution of `fps_l` and `fps_r` to `result` by schoolbook multiplication.
+// Raw products are accumulated in 64-bit integers and reduced only once every several rows.
+// Requires `result.size() >= fps_l.size() + fps_r.size() - 1` unless either span is empty.
+template <compatible_modint mint> void schoolbook_convolution(std::span<const mint> fps_l, std::span<const mint> fps_r, std::span<mint> result) {
+    if (fps_l.empty() || fps_r.empty()) return;
+    if (fps_l.size() > fps_r.size()) std::swap(fps_l, fps_r);
+    int n = fps_l.size(), m = fps_r.size();
+    assert(int(result.size()) >= n + m - 1);
+    uint64_t mod = mint::mod(), max_prod = (mod - 1) * (mod - 1);
+    int rows = max_prod ? std::max<uint64_t>(1, (~uint64_t(0) - mod) / max_prod) : n;
+    std::vector<uint64_t> acc(n + m - 1);
+    std::vector<uint32_t> raw(m);
+    for (int j = 0; j < m; j++) raw[j] = fps_r[j].val();
+    for (int i = 0; i < n; i++) {
+        uint64_t x = fps_l[i].val();
+        uint64_t *row = acc.data() + i;
+        for (int j = 0; j < m; j++) row[j] += x * raw[j];
+        if ((i + 1) % rows == 0) {
+            for (int k = std::max(0, i + 1 - rows); k < i + m; k++) acc[k] %= mod;
+        }
+    }
+    for (int k = 0; k < n + m - 1; k++) result[k] += mint(int64_t(acc[k] % mod));
+}
+
+// Adds the convolution of `fps_l` and `fps_r` to `result` by Karatsuba's algorithm,
+// falling back to `schoolbook_convolution` once the shorter operand has at most `threshold` coefficients.
+// Operands of different lengths are multiplied block by block, cutting the longer one into pieces of the shorter length.
+// Requires `result.size() >= fps_l.size() + fps_r.size() - 1` unless either span is empty.
+// Requires `threshold >= 1`.
+template <compatible_modint mint> void karatsuba_convolution(std::span<const mint> fps_l, std::span<const mint> fps_r, std::span<mint> result, int threshold = 32) {
+    if (fps_l.empty() || fps_r.empty()) return;
+    if (fps_l.size() > fps_r.size()) std::swap(fps_l, fps_r);
+    int n = fps_l.size(), m = fps_r.size();
+    assert(int(result.size()) >= n + m - 1);
+    if (n <= threshold) {
+        schoolbook_convolution(fps_l, fps_r, result);
+        return;
+    }
+    if (n < m) {
+        for (int i = 0; i < m; i += n) {
+            int len = std::min(n, m - i);
+            karatsuba_convolution(fps_l, fps_r.subspan(i, len), result.subspan(i), threshold);
+        }
+        return;
+    }
+
+    // `(a + b x^h)(c + d x^h) = ac + ((a + b)(c + d) - ac - bd) x^h + bd x^2h`
+    int h = n / 2, k = n - h;
+    std::vector<mint> low(h * 2 - 1), high(k * 2 - 1), mid(k * 2 - 1), sum_l(k), sum_r(k);
+    karatsuba_convolution(fps_l.first(h), fps_r.first(h), std::span<mint>(low), threshold);
+    karatsuba_convolution(fps_l.subspan(h), fps_r.subspan(h), std::span<mint>(high), threshold);
+    for (int i = 0; i < k; i++) {
+        sum_l[i] = fps_l[h + i] + (i < h ? fps_l[i] : mint{});
+        sum_r[i] = fps_r[h + i] + (i < h ? fps_r[i] : mint{});
+    }
+    karatsuba_convolution(std::span<const mint>(sum_l), std::span<const mint>(sum_r), std::span<mint>(mid), threshold);
+    for (int i = 0; i < h * 2 - 1; i++) {
+        result[i] += low[i];
+        mid[i] -= low[i];
+    }
+    for (int i = 0; i < k * 2 - 1; i++) {
+        result[h * 2 + i] += high[i];
+        result[h + i] += mid[i] - high[i];
+    }
+}
+
+// A reusable number theoretic transform over `mint` that owns its twiddle tables and scratch buffers.
+// A plan of size `n` supports transforms of every power-of-two length up to `n`.
+// Forward transforms produce values in bit-reversed order, which inverse transforms accept,
+// so pointwise operations between the two need no permutation.
+// Requires `mint::mod()` to be a prime `p` such that `p - 1` is divisible by the plan size.
+template <compatible_modint mint> struct ntt_plan {
+  private:
+    int _size{}, _mod{};
+    std::vector<mint> _roots, _iroots;
+    std::vector<mint> _buffer_l, _buffer_r;
+
+    // The minimum length from which `forward` and `inverse` use threads when asked to.
+    static constexpr int _PARALLEL_THRESHOLD = 1 << 16;
+    // The number of elements that a group of columns in a parallel transform is sized to.
+    static constexpr int _CACHE_ELEMENTS = 1 << 15;
+
+    void _inverse_unscaled(std::span<mint> fps) const {
+        int n = fps.size();
+        for (int len = 1; len < n; len *= 2) {
+            const mint *w = _iroots.data() + len;
+            for (int i = 0; i < n; i += len * 2) {
+                mint *a = fps.data() + i, *b = a + len;
+                for (int j = 0; j < len; j++) {
+                    mint u = a[j], v = b[j] * w[j];
+                    a[j] = u + v;
+                    b[j] = u - v;
+                }
+            }
+        }
+    }
+
+  public:
+    // The length of the shorter operand up to which `karatsuba_convolution` falls back to `schoolbook_convolution`.
+    static constexpr int SCHOOLBOOK_THRESHOLD = 32;
+    // The length of the shorter operand up to which `convolution` uses `karatsuba_convolution` instead of transforms.
+    static constexpr int KARATSUBA_THRESHOLD = 64;
+
+    // Returns whether transforms of length `n` are supported for the modulus of `mint`.
+    // Requires `n` to be a power of `2`.
+    static bool supports(int n) {
+        return (mint::mod() - 1) % n == 0;
+    }
+
+    ntt_plan() : ntt_plan(1) {}
+
+    // Constructs a plan for transforms of length up to `size`.
+    // Requires `size` to be a power of `2`.
+    // Requires `supports(size)`.
+    ntt_plan(int size) : _size(size), _mod(mint::mod()), _roots(std::max(size, 2)), _iroots(std::max(size, 2)) {
+        assert(std::has_single_bit(unsigned(size)));
+        assert(supports(size));
+        _roots[1] = _iroots[1] = 1;
+        if (size < 2) return;
+        int top = size / 2;
+        mint g = mint(least_primitive_root(_mod)).pow((_mod - 1) / size);
+        mint ig = g.inv();
+        for (int j = 0; j < top; j++) {
+            _roots[top + j] = j ? _roots[top + j - 1] * g : mint(1);
+            _iroots[top + j] = j ? _iroots[top + j - 1] * ig : mint(1);
+        }
+        for (int len = top / 2; len >= 1; len /= 2) {
+            for (int j = 0; j < len; j++) {
+                _roots[len + j] = _roots[(len + j) * 2];
+                _iroots[len + j] = _iroots[(len + j) * 2];
+            }
+        }
+    }
+
+    // Returns the maximum transform length supported by the plan.
+    int size() const {
+        return _size;
+    }
+
+    // Returns the modulus that the plan was constructed for.
+    int mod() const {
+        return _mod;
+    }
+
+    // Transforms `fps` in place from coefficients in natural order to values in bit-reversed order.
+    // Requires the size of `fps` to be a power of `2` not greater than `size()`.
+    void forward(std::span<mint> fps) const {
+        int n = fps.size();
+        assert(std::has_single_bit(unsigned(n)) && n <= _size);
+        for (int len = n / 2; len >= 1; len /= 2) {
+            const mint *w = _roots.data() + len;
+            for (int i = 0; i < n; i += len * 2) {
+                mint *a = fps.data() + i, *b = a + len;
+                for (int j = 0; j < len; j++) {
+                    mint u = a[j], v = b[j];
+                    a[j] = u + v;
+                    b[j] = (u - v) * w[j];
+                }
+            }
+        }
+    }
+
+    // Transforms `fps` in place from values in bit-reversed order to coefficients in natural order.
+    // Requires the size of `fps` to be a power of `2` not greater than `size()`.
+    void inverse(std::span<mint> fps) const {
+        int n = fps.size();
+        assert(std::has_single_bit(unsigned(n)) && n <= _size);
+        _inverse_unscaled(fps);
+        mint inv_n = mint(n).inv();
+        for (mint &c : fps) c *= inv_n;
+    }
+
+    // Transforms `fps` in place as `forward(fps)`, on `hardware_threads()` threads if `parallel` and `fps` is large.
+    // The length is split as `rows * cols`: the stages that pair elements of the same column run on groups of columns
+    // small enough to stay in cache, then each row of `cols` contiguous elements is transformed independently.
+    // Requires the size of `fps` to be a power of `2` not greater than `size()`.
+    void forward(std::span<mint> fps, bool parallel) const {
+        int n = fps.size();
+        if (!parallel || n < _PARALLEL_THRESHOLD) {
+            forward(fps);
+            return;
+        }
+        assert(std::has_single_bit(unsigned(n)) && n <= _size);
+        int cols = 1 << (std::countr_zero(unsigned(n)) / 2), rows = n / cols;
+        int width = std::max(1, _CACHE_ELEMENTS / rows);
+        parallel_for(cols, 1, [&](int, int64_t col_l, int64_t col_r) {
+            for (int c0 = col_l; c0 < col_r; c0 += width) {
+                int c1 = std::min<int64_t>(col_r, c0 + width);
+                for (int len = n / 2; len >= cols; len /= 2) {
+                    for (int i = 0; i < n; i += len * 2) {
+                        for (int q = 0; q < len; q += cols) {
+                            mint *a = fps.data() + i + q, *b = a + len;
+                            const mint *w = _roots.data() + len + q;
+                            for (int c = c0; c < c1; c++) {
+                                mint u = a[c], v = b[c];
+                                a[c] = u + v;
+                                b[c] = (u - v) * w[c];
+                            }
+                        }
+                    }
+                }
+            }
+        });
+        parallel_for(rows, 1, [&](int, int64_t row_l, int64_t row_r) {
+            for (int64_t r = row_l; r < row_r; r++) forward(fps.subspan(r * cols, cols));
+        });
+    }
+
+    // Transforms `fps` in place as `inverse(fps)`, on `hardware_threads()` threads if `parallel` and `fps` is large.
+    // Runs the steps of `forward(fps, true)` in reverse.
+    // Requires the size of `fps` to be a power of `2` not greater than `size()`.
+    void inverse(std::span<mint> fps, bool parallel) const {
+        int n = fps.size();
+        if (!parallel || n < _PARALLEL_THRESHOLD) {
+            inverse(fps);
+            return;
+        }
+        assert(std::has_single_bit(unsigned(n)) && n <= _size);
+        int cols = 1 << (std::countr_zero(unsigned(n)) / 2), rows = n / cols;
+        int width = std::max(1, _CACHE_ELEMENTS / rows);
+        parallel_for(rows, 1, [&](int, int64_t row_l, int64_t row_r) {
+            for (int64_t r = row_l; r < row_r; r++) _inverse_unscaled(fps.subspan(r * cols, cols));
+        });
+        mint inv_n = mint(n).inv();
+        parallel_for(cols, 1, [&](int, int64_t col_l, int64_t col_r) {
+            for (int c0 = col_l; c0 < col_r; c0 += width) {
+                int c1 = std::min<int64_t>(col_r, c0 + width);
+                for (int len = cols; len < n; len *= 2) {
+                    for (int i = 0; i < n; i += len * 2) {
+                        for (int q = 0; q < len; q += cols) {
+                            mint *a = fps.data() + i + q, *b = a + len;
+                            const mint *w = _iroots.data() + len + q;
+                            for (int c = c0; c < c1; c++) {
+                                mint u = a[c], v = b[c] * w[c];
+                                a[c] = u + v;
+                                b[c] = u - v;
+                            }
+                        }
+                    }
+                }
+                for (int r = 0; r < rows; r++) {
+                    for (int c = c0; c < c1; c++) fps[r * cols + c] *= inv_n;
+                }
+            }
+        });
+    }
+
+    // Given the transform of length `n` of a polynomial with at most `n` coefficients in the first half of `fps`,
+    // overwrites the second half so that `fps` holds the transform of length `2n` of the same polynomial.
+    // Costs one inverse and one forward transform of length `n`.
+    // Requires the size of `fps` to be a power of `2` not less than `2` and not greater than `size()`.
+    void extend(std::span<mint> fps) const {
+        int n = fps.size() / 2;
+        assert(n >= 1 && n * 2 <= _size && std::has_single_bit(unsigned(n)));
+        std::span<mint> upper = fps.subspan(n);
+        std::copy(fps.begin(), fps.begin() + n, upper.begin());
+        inverse(upper);
+        // The second half evaluates at the odd powers of the root of unity of order `2n`, i.e. `f(w x)`.
+        for (int j = 0; j < n; j++) upper[j] *= _roots[n + j];
+        forward(upper);
+    }
+
+    // Given the transform of length `2n` of `f` in `fps`, where `f(x) = f_0(x^2) + x f_1(x^2)`,
+    // overwrites the first half of `fps` with the transform of length `n` of `f_0`, or of `f_1` if `odd`.
+    // Requires the size of `fps` to be a power of `2` not less than `2` and not greater than `size()`.
+    void halve(std::span<mint> fps, bool odd) const {
+        int n = fps.size() / 2;
+        assert(n >= 1 && n * 2 <= _size && std::has_single_bit(unsigned(n)));
+        mint inv_2 = mint(2).inv();
+        if (!odd) {
+            for (int i = 0; i < n; i++) fps[i] = (fps[i * 2] + fps[i * 2 + 1]) * inv_2;
+            return;
+        }
+        // Positions `2i` and `2i + 1` hold `f(w)` and `f(-w)` with `w = w_2n^rev(i)`, where `rev` reverses `log2(n)` bits.
+        for (int i = 0, rev = 0; i < n; i++) {
+            fps[i] = (fps[i * 2] - fps[i * 2 + 1]) * inv_2 * _iroots[n + rev];
+            for (int bit = n >> 1; bit; bit >>= 1) {
+                rev ^= bit;
+                if (rev & bit) break;
+            }
+        }
+    }
+
+    // Multiplies `fps_l` by `fps_r` element-wise.
+    // Requires `fps_l` and `fps_r` to have the same size.
+    void multiply(std::span<mint> fps_l, std::span<const mint> fps_r) const {
+        assert(fps_l.size() == fps_r.size());
+        for (std::size_t i = 0; i < fps_l.size(); i++) fps_l[i] *= fps_r[i];
+    }
+
+    // Returns the convolution of `fps_l` and `fps_r`, reusing the plan's scratch buffers.
+    // Products whose shorter operand has at most `KARATSUBA_THRESHOLD` coefficients use `karatsuba_convolution`.
+    // Otherwise, when the longer operand is much longer, it is cut into blocks so that the shorter operand is transformed once
+    // and each transform is about twice the shorter length, whichever of the two needs fewer butterflies.
+    // If `parallel`, large transforms run on `hardware_threads()` threads.
+    // If either vector is empty, returns an empty vector.
+    // Requires `fps_l.size() + fps_r.size() - 1 <= size()` unless the shorter operand is short enough not to need transforms.
+    std::vector<mint> convolution(const std::vector<mint> &fps_l, const std::vector<mint> &fps_r, bool parallel = false) {
+        if (fps_l.empty() || fps_r.empty()) return {};
+        int len = fps_l.size() + fps_r.size() - 1;
+        std::vector<mint> result(len);
+        const std::vector<mint> &fps_s = fps_l.size() <= fps_r.size() ? fps_l : fps_r;
+        const std::vector<mint> &fps_t = fps_l.size() <= fps_r.size() ? fps_r : fps_l;
+        int len_s = fps_s.size(), len_t = fps_t.size();
+        if (len_s <= KARATSUBA_THRESHOLD) {
+            karatsuba_convolution<mint>(fps_s, fps_t, result, SCHOOLBOOK_THRESHOLD);
+            return result;
+        }
+
+        int n = std::bit_ceil(unsigned(len)), block = std::bit_ceil(unsigned(len_s) * 2), step = block - len_s + 1;
+        auto butterflies = [](int size, int count) { return int64_t(count) * size * std::bit_width(unsigned(size)); };
+        if (butterflies(block, 1 + (len_t + step - 1) / step * 2) < butterflies(n, 3)) n = block;
+        assert(n <= _size);
+        _buffer_r.assign(n, mint{});
+        std::copy(fps_s.begin(), fps_s.end(), _buffer_r.begin());
+        forward(_buffer_r, parallel);
+        int width = n - len_s + 1;
+        for (int i = 0; i < len_t; i += width) {
+            int count = std::min(width, len_t - i);
+            _buffer_l.assign(n, mint{});
+            std::copy(fps_t.begin() + i, fps_t.begin() + i + count, _buffer_l.begin());
+            forward(_buffer_l, parallel);
+            multiply(_buffer_l, _buffer_r);
+            inverse(_buffer_l, parallel);
+            for (int j = 0; j < n && i + j < len; j++) result[i + j] += _buffer_l[j];
+        }
+        return result;
+    }
+};
+
+// Returns a plan owned by the calling thread that supports transforms of length `n`.
+// The plan is rebuilt only when `n` exceeds its size or the modulus of `mint` has changed.
+// Requires `n` to be a power of `2`.
+template <compatible_modint mint> ntt_plan<mint>& shared_ntt_plan(int n) {
+    thread_local ntt_plan<mint> plan;
+    if (plan.size() < n || plan.mod() != mint::mod()) plan = ntt_plan<mint>(n);
+    return plan;
+}
+
+// Returns the convolution of `fps_l` and `fps_r` for an arbitrary modulus of `mint`.
+// The exact products are computed modulo three NTT-friendly primes and combined by the Chinese remainder theorem,
+// which is exact while `min(fps_l.size(), fps_r.size()) * (mint::mod() - 1)^2` stays below their product (about `2^85`).
+// If `parallel`, large transforms and the reconstruction run on `hardware_threads()` threads.
+// If either vector is empty, returns an empty vector.
+// Requires `fps_l.size() + fps_r.size() - 1 <= (1 << 24)`.
+template <compatible_modint mint> std::vector<mint> convolution_arbitrary_mod(const std::vector<mint> &fps_l, const std::vector<mint> &fps_r, bool parallel = false) {
+    if (fps_l.empty() || fps_r.empty()) return {};
+    constexpr unsigned MOD1 = 754974721, MOD2 = 167772161, MOD3 = 469762049;
+    using mint1 = atcoder::static_modint<MOD1>;
+    using mint2 = atcoder::static_modint<MOD2>;
+    using mint3 = atcoder::static_modint<MOD3>;
+    int len = fps_l.size() + fps_r.size() - 1;
+    assert(len <= (1 << 24));
+    auto convolve = [&]<typename pmint>() {
+        std::vector<pmint> l(fps_l.size()), r(fps_r.size());
+        for (std::size_t i = 0; i < fps_l.size(); i++) l[i] = fps_l[i].val();
+        for (std::size_t i = 0; i < fps_r.size(); i++) r[i] = fps_r[i].val();
+        return shared_ntt_plan<pmint>(std::bit_ceil(unsigned(len))).convolution(l, r, parallel);
+    };
+    std::vector<mint1> c1 = convolve.template operator()<mint1>();
+    std::vector<mint2> c2 = convolve.template operator()<mint2>();
+    std::vector<mint3> c3 = convolve.template operator()<mint3>();
+
+    // Garner's algorithm: `x = x1 + x2 * MOD1 + x3 * MOD1 * MOD2` with each `xi` reduced modulo `MODi`.
+    const mint2 inv1 = mint2(MOD1).inv();
+    const mint3 inv12 = (mint3(MOD1) * mint3(MOD2)).inv();
+    const mint m1 = mint(MOD1), m12 = mint(int64_t(MOD1) * MOD2 % mint::mod());
+    std::vector<mint> result(len);
+    auto reconstruct = [&](int, int64_t l, int64_t r) {
+        for (int64_t i = l; i < r; i++) {
+            unsigned x1 = c1[i].val();
+            unsigned x2 = ((c2[i] - x1) * inv1).val();
+            unsigned x3 = ((c3[i] - x1 - mint3(x2) * MOD1) * inv12).val();
+            result[i] = mint(x1) + mint(x2) * m1 + mint(x3) * m12;
+        }
+    };
+    if (parallel) parallel_for(len, 1 << 16, reconstruct);
+    else reconstruct(0, 0, len);
+    return result;
+}
+
+// Returns the convolution of `fps_l` and `fps_r` using the calling thread's shared plan.
+// Short products use `karatsuba_convolution` for any modulus.
+// Falls back to `convolution_arbitrary_mod` when the modulus of `mint` does not support the required transform length.
+// If `parallel`, large transforms run on `hardware_threads()` threads.
+// If either vector is empty, returns an empty vector.
+template <compatible_modint mint> std::vector<mint> ntt_convolution(const std::vector<mint> &fps_l, const std::vector<mint> &fps_r, bool parallel = false) {
+    if (fps_l.empty() || fps_r.empty()) return {};
+    int n = std::bit_ceil(fps_l.size() + fps_r.size() - 1);
+    if (std::min(fps_l.size(), fps_r.size()) <= ntt_plan<mint>::KARATSUBA_THRESHOLD) {
+        std::vector<mint> result(fps_l.size() + fps_r.size() - 1);
+        karatsuba_convolution<mint>(fps_l, fps_r, result, ntt_plan<mint>::SCHOOLBOOK_THRESHOLD);
+        return result;
+    }
+    if (!ntt_plan<mint>::supports(n)) return convolution_arbitrary_mod(fps_l, fps_r, parallel);
+    return shared_ntt_plan<mint>(n).convolution(fps_l, fps_r, parallel);
+}
+
+}  // namespace kotone
+
+#endif  // KOTONE_NTT_HPP
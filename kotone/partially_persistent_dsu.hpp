@@ -2,23 +2,42 @@
 #define KOTONE_PARTIALLY_PERSISTENT_DSU_HPP 1
 
 #include <vector>
+#include <span>
+#include <tuple>
+#include <limits>
 #include <algorithm>
 #include <cassert>
+#include <kotone/internal_parallel>
 
 namespace kotone {
 
 // A partially persistent DSU that monitors connectivity in different versions of a graph.
+// Uses union by size without path compression, so each node gains a parent exactly once;
+// the parent and the version of that link are stored in one flat array, and `leader` follows them without searching.
+// Component sizes are stored in one flat array of records, where each record points to the previous record of the same leader
+// and carries a skew-binary jump pointer, so the size at any version is found in `O(log n)` steps.
 struct partially_persistent_dsu {
   private:
+    struct _link {
+        int version, parent;
+    };
+    struct _record {
+        int version, size, prev, jump, depth;
+    };
+
     int _num_nodes = 0, _version = 0;
-    std::vector<std::vector<std::pair<int, int>>> _vec;
+    std::vector<_link> _links;
+    std::vector<int> _last;
+    // `_records[0]` is a sentinel shared by all nodes for the size `1` at version `0`.
+    std::vector<_record> _records{{0, 1, 0, 0, 0}};
 
   public:
     partially_persistent_dsu() {}
 
     // Constructs DSU for a graph with the specified number of nodes and no edges.
     // Requires `0 <= num_nodes <= 100000000`.
-    partially_persistent_dsu(int num_nodes) : _num_nodes(num_nodes), _vec(num_nodes, {{0, -1}}) {
+    partially_persistent_dsu(int num_nodes)
+        : _num_nodes(num_nodes), _links(num_nodes, {std::numeric_limits<int>::max(), -1}), _last(num_nodes) {
         assert(0 <= num_nodes && num_nodes <= 100000000);
     }
 
@@ -34,20 +53,39 @@ struct partially_persistent_dsu {
     int leader(int v, int t) const {
         assert(0 <= v && v < _num_nodes);
         assert(0 <= t && t <= _version);
-        auto [ver, val] = _vec[v].back();
-        if (ver > t || val < 0) return v;
-        return leader(val, t);
+        while (_links[v].version <= t) v = _links[v].parent;
+        return v;
+    }
+
+    // Returns whether nodes `u` and `v` are connected in version `t`.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    // Requires `0 <= t <= version`.
+    bool connected(int u, int v, int t) const {
+        return leader(u, t) == leader(v, t);
+    }
+
+    // Returns `connected(u, v, t)` for each query `(u, v, t)` in `queries`, evaluated on `hardware_threads()` threads.
+    // Requires each query to satisfy the requirements of `connected`.
+    std::vector<bool> connected(std::span<const std::tuple<int, int, int>> queries) const {
+        std::vector<char> result(queries.size());
+        parallel_for(queries.size(), 1 << 16, [&](int, int64_t l, int64_t r) {
+            for (int64_t i = l; i < r; i++) {
+                auto [u, v, t] = queries[i];
+                result[i] = connected(u, v, t);
+            }
+        });
+        return std::vector<bool>(result.begin(), result.end());
     }
 
     // Returns the number of nodes in the connected component containing node `v` in version `t`.
     // If `t == 0`, returns `1`.
     // Requires `0 <= v < num_nodes`.
-    // Requires `0 <= t <= latest_version`.
+    // Requires `0 <= t <= version`.
     int size(int v, int t) const {
-        assert(0 <= v && v < _num_nodes);
-        assert(0 <= t && t <= _version);
-        v = leader(v, t);
-        return -std::prev(std::upper_bound(_vec[v].begin(), _vec[v].end(), std::pair{t, _num_nodes}))->second;
+        int x = _last[leader(v, t)];
+        while (_records[x].version > t) x = _records[_records[x].jump].version > t ? _records[x].jump : _records[x].prev;
+        return _records[x].size;
     }
 
     // Adds an edge between nodes `u` and `v` then returns a pair containing:
@@ -61,11 +99,17 @@ struct partially_persistent_dsu {
         v = leader(v, _version);
         _version++;
         if (u == v) return {u, _version};
-        int size_u = -_vec[u].back().second;
-        int size_v = -_vec[v].back().second;
+        int size_u = _records[_last[u]].size;
+        int size_v = _records[_last[v]].size;
         if (size_u < size_v) std::swap(u, v);
-        _vec[u].emplace_back(_version, -size_u - size_v);
-        _vec[v].emplace_back(_version, u);
+        _links[v] = {_version, u};
+
+        // The jump pointer skips as far as the previous one did twice, so that chains are searched in `O(log n)` steps.
+        int p = _last[u], j = _records[p].jump;
+        int jump = _records[p].depth - _records[j].depth == _records[j].depth - _records[_records[j].jump].depth
+            ? _records[j].jump : p;
+        _last[u] = _records.size();
+        _records.push_back({_version, size_u + size_v, p, jump, _records[p].depth + 1});
         return {u, _version};
     }
 };
@@ -0,0 +1,424 @@
+#ifndef KOTONE_PERSISTENT_LAZY_TREAP_HPP
+#define KOTONE_PERSISTENT_LAZY_TREAP_HPP 1
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cassert>
+#include <kotone/random>
+#include <kotone/memory_pool>
+
+namespace kotone {
+
+// A self-contained memory manager for fully-persistent implicit treaps with lazy propagation.
+// Nodes are shared between versions and reference-counted, so no operation invalidates its arguments.
+// Every pointer returned by the manager holds a reference that must be released by `deallocate_treap()`.
+// Requires the following functions:
+// - `S op(S val_l, S val_r)`
+// - `S e()`
+// - `S mapping(F app, S val)`
+// - `F composition(F app_outer, F app_inner)`
+// - `F id()`
+//
+// Reference: https://nyaannyaan.github.io/library/rbst/persistent-rbst.hpp
+template <typename S, S (*op)(S, S), S (*e)(), typename F, S (*mapping)(F, S), F (*composition)(F, F), F (*id)()>
+struct persistent_lazy_treap_manager {
+    // A node for treap-related operations.
+    struct lazy_treap {
+        friend struct persistent_lazy_treap_manager;
+
+      private:
+        lazy_treap *_left = nullptr, *_right = nullptr;
+        S _val = e(), _prod = e(), _prod_rev = e();
+        F _lazy = id();
+        int64_t _size = 1;
+        int _ref = 1;
+        bool _rev = false;
+
+      public:
+        // Constructs a treap node with value initialized to `e()`.
+        lazy_treap() {}
+
+        // Constructs a treap node with the specified value.
+        lazy_treap(S val) : _val(val), _prod(val), _prod_rev(val) {}
+    };
+
+  private:
+    memory_pool<lazy_treap> _pool;
+    std::vector<lazy_treap*> _buffer;
+
+    static lazy_treap* _retain(lazy_treap *node) {
+        if (node) node->_ref++;
+        return node;
+    }
+
+    void _release(lazy_treap *root) {
+        if (!root) return;
+        std::vector<lazy_treap*> &stack = _buffer;
+        stack.assign(1, root);
+        while (stack.size()) {
+            lazy_treap *node = stack.back();
+            stack.pop_back();
+            if (--node->_ref) continue;
+            if (node->_left) stack.push_back(node->_left);
+            if (node->_right) stack.push_back(node->_right);
+            _pool.deallocate(node);
+        }
+    }
+
+    // Returns a node that is referenced only by the caller, copying `node` if it is shared.
+    // Consumes one reference to `node`.
+    lazy_treap* _own(lazy_treap *node) {
+        if (!node || node->_ref == 1) return node;
+        node->_ref--;
+        lazy_treap *result = _pool.allocate(*node);
+        result->_ref = 1;
+        _retain(result->_left);
+        _retain(result->_right);
+        return result;
+    }
+
+    static void _reverse(lazy_treap *node) {
+        std::swap(node->_left, node->_right);
+        std::swap(node->_prod, node->_prod_rev);
+        node->_rev ^= true;
+    }
+
+    static void _apply(lazy_treap *node, F app) {
+        node->_lazy = composition(app, node->_lazy);
+        node->_val = mapping(app, node->_val);
+        node->_prod = mapping(app, node->_prod);
+        node->_prod_rev = mapping(app, node->_prod_rev);
+    }
+
+    // Pushing does not change the sequence represented by `node`, so `node` itself may be shared.
+    void _push(lazy_treap *node) {
+        if (!node) return;
+        if (node->_rev) {
+            if (node->_left) _reverse(node->_left = _own(node->_left));
+            if (node->_right) _reverse(node->_right = _own(node->_right));
+            node->_rev = false;
+        }
+        if (node->_lazy != id()) {
+            if (node->_left) _apply(node->_left = _own(node->_left), node->_lazy);
+            if (node->_right) _apply(node->_right = _own(node->_right), node->_lazy);
+            node->_lazy = id();
+        }
+    }
+
+    void _update(lazy_treap *node) const {
+        node->_size = 1;
+        node->_prod = node->_prod_rev = node->_val;
+        if (node->_left) {
+            node->_size += node->_left->_size;
+            node->_prod = op(node->_left->_prod, node->_prod);
+            node->_prod_rev = op(node->_prod_rev, node->_left->_prod_rev);
+        }
+        if (node->_right) {
+            node->_size += node->_right->_size;
+            node->_prod = op(node->_prod, node->_right->_prod);
+            node->_prod_rev = op(node->_right->_prod_rev, node->_prod_rev);
+        }
+    }
+
+    lazy_treap* _build(const std::vector<S> &vec, int l, int r) {
+        if (l == r) return nullptr;
+        int m = (l + r) / 2;
+        lazy_treap *node = _pool.allocate(vec[m]);
+        node->_left = _build(vec, l, m);
+        node->_right = _build(vec, m + 1, r);
+        _update(node);
+        return node;
+    }
+
+    // Consumes one reference to each of `root_l` and `root_r`.
+    lazy_treap* _merge(lazy_treap *root_l, lazy_treap *root_r) {
+        if (!root_l || !root_r) return root_l ? root_l : root_r;
+        if (randint() % uint64_t(root_l->_size + root_r->_size) < uint64_t(root_l->_size)) {
+            root_l = _own(root_l);
+            _push(root_l);
+            root_l->_right = _merge(root_l->_right, root_r);
+            _update(root_l);
+            return root_l;
+        } else {
+            root_r = _own(root_r);
+            _push(root_r);
+            root_r->_left = _merge(root_l, root_r->_left);
+            _update(root_r);
+            return root_r;
+        }
+    }
+
+    // Consumes one reference to `root`.
+    std::pair<lazy_treap*, lazy_treap*> _split(lazy_treap *root, int64_t index) {
+        if (!root) return {nullptr, nullptr};
+        if (index == 0) return {nullptr, root};
+        if (index == root->_size) return {root, nullptr};
+        root = _own(root);
+        _push(root);
+        int64_t left_size = size(root->_left);
+        if (index <= left_size) {
+            auto [l, r] = _split(root->_left, index);
+            root->_left = r;
+            _update(root);
+            return {l, root};
+        } else {
+            auto [l, r] = _split(root->_right, index - left_size - 1);
+            root->_right = l;
+            _update(root);
+            return {root, r};
+        }
+    }
+
+    S _get_prod(lazy_treap *root, int64_t l, int64_t r) {
+        if (!root || r <= 0 || root->_size <= l) return e();
+        if (l <= 0 && root->_size <= r) return root->_prod;
+        _push(root);
+        int64_t left_size = size(root->_left);
+        S result = _get_prod(root->_left, l, r);
+        if (l <= left_size && left_size < r) result = op(result, root->_val);
+        return op(result, _get_prod(root->_right, l - left_size - 1, r - left_size - 1));
+    }
+
+    void _to_vector(lazy_treap *root, std::vector<S> &vec) {
+        if (!root) return;
+        _push(root);
+        _to_vector(root->_left, vec);
+        vec.push_back(root->_val);
+        _to_vector(root->_right, vec);
+    }
+
+    template <typename G> int64_t _max_right(lazy_treap *root, const G &g, S &acc) {
+        if (!root) return 0;
+        _push(root);
+        S new_acc = op(acc, root->_prod);
+        if (g(new_acc)) {
+            acc = new_acc;
+            return size(root);
+        }
+        int64_t left_size = size(root->_left);
+        int64_t result = _max_right(root->_left, g, acc);
+        if (result < left_size) return result;
+        new_acc = op(acc, root->_val);
+        if (!g(new_acc)) return left_size;
+        acc = new_acc;
+        return _max_right(root->_right, g, acc) + left_size + 1;
+    }
+
+    template <typename G> int64_t _min_left(lazy_treap *root, const G &g, S &acc) {
+        if (!root) return 0;
+        _push(root);
+        S new_acc = op(root->_prod, acc);
+        if (g(new_acc)) {
+            acc = new_acc;
+            return 0;
+        }
+        int64_t left_size = size(root->_left);
+        int64_t result = _min_left(root->_right, g, acc);
+        if (result > 0) return result + left_size + 1;
+        new_acc = op(root->_val, acc);
+        if (!g(new_acc)) return left_size + 1;
+        acc = new_acc;
+        return _min_left(root->_left, g, acc);
+    }
+
+  public:
+    // Constructs and returns a pointer to a treap node with value initialized to `e()`.
+    lazy_treap* allocate_node() {
+        return _pool.allocate();
+    }
+
+    // Constructs and returns a pointer to a treap node with the specified value.
+    lazy_treap* allocate_node(S val) {
+        return _pool.allocate(val);
+    }
+
+    // Converts the vector to a persistent lazy treap and returns a pointer to the root of the treap.
+    // If `vec` is empty, returns `nullptr`.
+    lazy_treap* allocate_treap(const std::vector<S> &vec) {
+        _pool.reserve(vec.size());
+        return _build(vec, 0, vec.size());
+    }
+
+    // Releases the reference held by `root`.
+    // Nodes that are no longer referenced by any treap are returned to the memory pool.
+    void deallocate_treap(lazy_treap *root) {
+        _release(root);
+    }
+
+    // Returns a new reference to the treap in O(1) time.
+    // The returned pointer must be released separately by `deallocate_treap()`.
+    lazy_treap* copy(lazy_treap *root) {
+        return _retain(root);
+    }
+
+    // Returns the size of the treap.
+    int64_t size(lazy_treap *root) const {
+        if (root) return root->_size;
+        return 0;
+    }
+
+    // Returns a vector containing the values of the treap.
+    std::vector<S> to_vector(lazy_treap *root) {
+        std::vector<S> result;
+        result.reserve(size(root));
+        _to_vector(root, result);
+        return result;
+    }
+
+    // Returns a pointer to the root of the concatenation of `root_l` and `root_r`.
+    // `root_l` and `root_r` may share nodes or be identical.
+    lazy_treap* merge(lazy_treap *root_l, lazy_treap *root_r) {
+        return _merge(_retain(root_l), _retain(root_r));
+    }
+
+    // Returns a pair of pointers to the roots of the intervals `[0, index)` and `[index, size(root))`.
+    // Requires `0 <= index <= size(root)`.
+    std::pair<lazy_treap*, lazy_treap*> split(lazy_treap *root, int64_t index) {
+        assert(0 <= index && index <= size(root));
+        return _split(_retain(root), index);
+    }
+
+    // Returns the product of the treap.
+    // If the treap is empty, returns `e()`.
+    S get_prod(lazy_treap *root) const {
+        if (root) return root->_prod;
+        return e();
+    }
+
+    // Returns the product of the interval `[l, r)` in the treap.
+    // Requires `0 <= l <= r <= size(root)`.
+    S get_prod(lazy_treap *root, int64_t l, int64_t r) {
+        assert(0 <= l && l <= r && r <= size(root));
+        return _get_prod(root, l, r);
+    }
+
+    // Returns the value of the node at the specified index in the treap.
+    // Requires `0 <= index < size(root)`.
+    S get_val(lazy_treap *root, int64_t index) {
+        assert(0 <= index && index < size(root));
+        lazy_treap *curr = root;
+        while (true) {
+            _push(curr);
+            int64_t left_size = size(curr->_left);
+            if (index == left_size) return curr->_val;
+            if (index < left_size) curr = curr->_left;
+            else curr = curr->_right, index -= left_size + 1;
+        }
+    }
+
+    // Returns a pointer to the root of a copy of the treap with the value at the specified index reassigned.
+    // Requires `0 <= index < size(root)`.
+    lazy_treap* set_val(lazy_treap *root, int64_t index, S val) {
+        assert(0 <= index && index < size(root));
+        auto [nl, nml] = _split(_retain(root), index);
+        auto [nmr, nr] = _split(nml, 1);
+        nmr = _own(nmr);
+        nmr->_val = val;
+        _update(nmr);
+        return _merge(_merge(nl, nmr), nr);
+    }
+
+    // Returns a pointer to the root of a copy of the treap with `new_treap` inserted at the specified index.
+    // `root` and `new_treap` may share nodes or be identical.
+    // Requires `0 <= index <= size(root)`.
+    lazy_treap* insert(lazy_treap *root, lazy_treap *new_treap, int64_t index) {
+        assert(0 <= index && index <= size(root));
+        auto [nl, nr] = _split(_retain(root), index);
+        return _merge(_merge(nl, _retain(new_treap)), nr);
+    }
+
+    // Returns a pointer to the root of a copy of the treap with the interval `[l, r)` removed.
+    // Requires `0 <= l <= r <= size(root)`.
+    lazy_treap* remove(lazy_treap *root, int64_t l, int64_t r) {
+        assert(0 <= l && l <= r && r <= size(root));
+        auto [nl, nml] = _split(_retain(root), l);
+        auto [nmr, nr] = _split(nml, r - l);
+        _release(nmr);
+        return _merge(nl, nr);
+    }
+
+    // Returns a pointer to the root of the interval `[l, r)` of the treap.
+    // Requires `0 <= l <= r <= size(root)`.
+    lazy_treap* slice(lazy_treap *root, int64_t l, int64_t r) {
+        assert(0 <= l && l <= r && r <= size(root));
+        auto [nl, nml] = _split(_retain(root), l);
+        auto [nmr, nr] = _split(nml, r - l);
+        _release(nl);
+        _release(nr);
+        return nmr;
+    }
+
+    // Returns a pointer to the root of a reversed copy of the entire treap.
+    lazy_treap* reverse(lazy_treap *root) {
+        if (!root) return nullptr;
+        lazy_treap *result = _own(_retain(root));
+        _reverse(result);
+        return result;
+    }
+
+    // Returns a pointer to the root of a copy of the treap with the interval `[l, r)` reversed.
+    // Requires `0 <= l <= r <= size(root)`.
+    lazy_treap* reverse(lazy_treap *root, int64_t l, int64_t r) {
+        assert(0 <= l && l <= r && r <= size(root));
+        auto [nl, nml] = _split(_retain(root), l);
+        auto [nmr, nr] = _split(nml, r - l);
+        if (nmr) _reverse(nmr = _own(nmr));
+        return _merge(_merge(nl, nmr), nr);
+    }
+
+    // Returns a pointer to the root of a copy of the entire treap transformed under the specified application.
+    lazy_treap* apply(lazy_treap *root, F app) {
+        if (!root) return nullptr;
+        lazy_treap *result = _own(_retain(root));
+        _apply(result, app);
+        return result;
+    }
+
+    // Returns a pointer to the root of a copy of the treap with the interval `[l, r)` transformed
+    // under the specified application.
+    // Requires `0 <= l <= r <= size(root)`.
+    lazy_treap* apply(lazy_treap *root, F app, int64_t l, int64_t r) {
+        assert(0 <= l && l <= r && r <= size(root));
+        auto [nl, nml] = _split(_retain(root), l);
+        auto [nmr, nr] = _split(nml, r - l);
+        if (nmr) _apply(nmr = _own(nmr), app);
+        return _merge(_merge(nl, nmr), nr);
+    }
+
+    // Returns the maximum `r` such that `g(get_prod(root, l, r)) == true`.
+    // Requires `0 <= l <= size(root)`.
+    // Requires `bool g(S val)` to be a monotonic predicate.
+    // Requires `g(e()) == true`.
+    template <typename G> int64_t max_right(lazy_treap *root, int64_t l, G g) {
+        assert(0 <= l && l <= size(root));
+        assert(g(e()));
+        if (l == size(root)) return l;
+        auto [nl, nr] = _split(_retain(root), l);
+        S acc = e();
+        int64_t result = _max_right(nr, g, acc) + l;
+        _release(nl);
+        _release(nr);
+        return result;
+    }
+
+    // Returns the minimum `l` such that `g(get_prod(root, l, r)) == true`.
+    // Requires `0 <= r <= size(root)`.
+    // Requires `bool g(S val)` to be a monotonic predicate.
+    // Requires `g(e()) == true`.
+    template <typename G> int64_t min_left(lazy_treap *root, int64_t r, G g) {
+        assert(0 <= r && r <= size(root));
+        assert(g(e()));
+        if (r == 0) return r;
+        auto [nl, nr] = _split(_retain(root), r);
+        S acc = e();
+        int64_t result = _min_left(nl, g, acc);
+        _release(nl);
+        _release(nr);
+        return result;
+    }
+};
+
+}  // namespace kotone
+
+#endif  // KOTONE_PERSISTENT_LAZY_TREAP_HPP
@@ -0,0 +1,92 @@
+#ifndef KOTONE_RELAXED_CONVOLUTION_HPP
+#define KOTONE_RELAXED_CONVOLUTION_HPP 1
+
+#include <vector>
+#include <span>
+#include <bit>
+#include <cassert>
+#include <kotone/ntt>
+#include <kotone/internal_type_traits>
+
+namespace kotone {
+
+// An online convolution that receives `f[n]` and `g[n]` one index at a time
+// and returns `(f * g)[n]` right away, so `f[n + 1]` and `g[n + 1]` may depend on it.
+// Answers `n` queries in `O(n log^2 n)` time in total.
+// Pairs `(i, j)` with `i, j >= 1` are split into squares `[s, 2s) x [ms, (m + 1)s)` (for `m >= 1`)
+// and their mirrors (for `m >= 2`), each multiplied as soon as both sides are known,
+// which is exactly one index before the square first contributes.
+template <compatible_modint mint> struct relaxed_convolution {
+  private:
+    static constexpr int _NAIVE_THRESHOLD = 32;
+    std::vector<mint> _f, _g, _h;
+    // `_trans_f[k]` and `_trans_g[k]` hold the transforms of length `2^(k + 1)` of `f[2^k, 2^(k + 1))` and `g[2^k, 2^(k + 1))`,
+    // which every square of side `2^k` shares.
+    std::vector<std::vector<mint>> _trans_f, _trans_g;
+    std::vector<mint> _buffer;
+
+    // Adds the product of `f[start_f, start_f + s)` and `g[start_g, start_g + s)` to `h`,
+    // where either `start_f == s` or `start_g == s`.
+    void _add_square(int s, int start_f, int start_g) {
+        std::span<mint> out(_h.data() + start_f + start_g, s * 2 - 1);
+        std::span<const mint> block_f(_f.data() + start_f, s), block_g(_g.data() + start_g, s);
+        if (s <= _NAIVE_THRESHOLD || !ntt_plan<mint>::supports(s * 2)) {
+            if (s <= _NAIVE_THRESHOLD) schoolbook_convolution<mint>(block_f, block_g, out);
+            else {
+                std::vector<mint> prod = ntt_convolution(std::vector<mint>(block_f.begin(), block_f.end()), std::vector<mint>(block_g.begin(), block_g.end()));
+                for (int i = 0; i < s * 2 - 1; i++) out[i] += prod[i];
+            }
+            return;
+        }
+        int k = std::countr_zero(unsigned(s));
+        const ntt_plan<mint> &plan = shared_ntt_plan<mint>(s * 2);
+        if (int(_trans_f.size()) <= k) {
+            _trans_f.resize(k + 1);
+            _trans_g.resize(k + 1);
+        }
+        if (_trans_f[k].empty()) {
+            _trans_f[k].assign(s * 2, mint{});
+            _trans_g[k].assign(s * 2, mint{});
+            std::copy(_f.begin() + s, _f.begin() + s * 2, _trans_f[k].begin());
+            std::copy(_g.begin() + s, _g.begin() + s * 2, _trans_g[k].begin());
+            plan.forward(_trans_f[k]);
+            plan.forward(_trans_g[k]);
+        }
+        if (start_f == s && start_g == s) {
+            _buffer = _trans_g[k];
+        } else {
+            std::span<const mint> other = start_f == s ? block_g : block_f;
+            _buffer.assign(s * 2, mint{});
+            std::copy(other.begin(), other.end(), _buffer.begin());
+            plan.forward(_buffer);
+        }
+        plan.multiply(_buffer, start_f == s ? _trans_f[k] : _trans_g[k]);
+        plan.inverse(_buffer);
+        for (int i = 0; i < s * 2 - 1; i++) out[i] += _buffer[i];
+    }
+
+  public:
+    // Returns the number of indices received so far.
+    int size() const noexcept {
+        return _f.size();
+    }
+
+    // Receives `f[n]` and `g[n]`, where `n == size()`, and returns `(f * g)[n]`.
+    mint push(const mint &f, const mint &g) {
+        int n = _f.size();
+        _f.push_back(f);
+        _g.push_back(g);
+        if (int(_h.size()) < n * 2 + 1) _h.resize(std::max<std::size_t>(n * 2 + 1, _h.size() * 2));
+        _h[n] += n ? f * _g[0] + _f[0] * g : f * g;
+        for (int s = 1; (n + 1) % s == 0 && n + 1 >= s * 2; s *= 2) {
+            int m = (n + 1) / s - 1;
+            _add_square(s, s, m * s);
+            if (m >= 2) _add_square(s, m * s, s);
+        }
+        return _h[n];
+    }
+};
+
+}  // namespace kotone
+
+#endif  // KOTONE_RELAXED_CONVOLUTION_HPP
@@ -2,52 +2,65 @@
 #define KOTONE_REROOTING_HPP 1
 
 #include <vector>
+#include <utility>
+#include <algorithm>
 #include <cassert>
 #include <kotone/dsu>
+#include <kotone/internal_csr>
+#include <kotone/heavy_light_decomposition>
 
 namespace kotone {
 
 // Maintains dynamic programming for commutative monoids at different roots of trees in a forest.
+// Nodes are laid out in breadth-first order, where the children of each node occupy a contiguous interval,
+// so both passes run iteratively and scan the table sequentially, and deep trees are safe.
+// The prefix and suffix products at each node share one scratch buffer sized by the maximum degree.
 // Requires the following functions:
 // - `S merge(S dp_l, S dp_r)`
 // - `S apply(S dp_child, int child, int parent)`
 // - `S identity()`
 template <typename S, S (*merge)(S, S), S (*apply)(S, int, int), S (*identity)()> struct rerooting {
   private:
-    int _size = 0;
-    std::vector<std::vector<int>> _tree;
-    std::vector<S> _dp;
+    int _size = 0, _max_degree = 0;
+    std::vector<std::pair<int, int>> _edges;
+    // `_order[i]` is the node at position `i`, whose children are at positions `[_child_start[i], _child_start[i + 1])`
+    // and whose parent is `_parent[i]`, or `-1` for a root.
+    std::vector<int> _order, _child_start, _parent;
     kotone::dsu<int> _dsu;
+    bool _requires_build = false;
 
-    void _dfs_forward(int u, int p) {
-        _dp[u] = identity();
-        for (int v : _tree[u]) {
-            if (v == p) continue;
-            _dfs_forward(v, u);
-            _dp[u] = merge(_dp[u], apply(_dp[v], v, u));
-        }
-    }
+    void _build() {
+        if (!_requires_build) return;
+        _requires_build = false;
+        int n = _size;
+        csr_graph graph(n, _edges);
+        _max_degree = graph.max_degree();
 
-    void _dfs_reverse(int u, int p, S parent_acc, std::vector<S> &result) {
-        int deg = static_cast<int>(_tree[u].size());
-        std::vector<S> prefix(deg + 1, identity()), suffix(deg + 1, identity());
-        for (int i = 0; i < deg; i++) {
-            int v = _tree[u][i];
-            if (v == p) prefix[i + 1] = merge(prefix[i], apply(parent_acc, p, u));
-            else prefix[i + 1] = merge(prefix[i], apply(_dp[v], v, u));
+        // `_order` doubles as the queue of a breadth-first search that starts from every root at once,
+        // so that the children of consecutive positions stay contiguous across trees.
+        _order.resize(n);
+        _child_start.resize(n + 1);
+        _parent.resize(n);
+        std::vector<char> visited(n);
+        int tail = 0;
+        for (int r = 0; r < n; r++) {
+            if (r != _dsu.leader(r)) continue;
+            visited[r] = true;
+            _parent[tail] = -1;
+            _order[tail++] = r;
         }
-        for (int i = deg - 1; i >= 0; i--) {
-            int v = _tree[u][i];
-            if (v == p) suffix[i] = merge(suffix[i + 1], apply(parent_acc, p, u));
-            else suffix[i] = merge(suffix[i + 1], apply(_dp[v], v, u));
-        }
-        result[u] = prefix[deg];
-        for (int i = 0; i < deg; i++) {
-            int v = _tree[u][i];
-            if (v == p) continue;
-            S acc = merge(prefix[i], suffix[i + 1]);
-            _dfs_reverse(v, u, acc, result);
+        for (int head = 0; head < n; head++) {
+            int u = _order[head];
+            _child_start[head] = tail;
+            for (int j = graph.start[u]; j < graph.start[u + 1]; j++) {
+                int v = graph.adjacent[j];
+                if (visited[v]) continue;
+                visited[v] = true;
+                _parent[tail] = u;
+                _order[tail++] = v;
+            }
         }
+        _child_start[n] = n;
     }
 
   public:
@@ -55,10 +68,8 @@ template <typename S, S (*merge)(S, S), S (*apply)(S, int, int), S (*identity)()
 
     // Constructs a forest with the specified number of disconnected nodes.
     // Requires `0 <= num_nodes <= 100000000`.
-    rerooting(int num_nodes) : _size(num_nodes), _dsu(num_nodes) {
+    rerooting(int num_nodes) : _size(num_nodes), _dsu(num_nodes), _requires_build(true) {
         assert(0 <= num_nodes && num_nodes <= 100000000);
-        _tree.resize(num_nodes);
-        _dp.resize(num_nodes);
     }
 
     // Returns the number of nodes in the forest.
@@ -73,21 +84,234 @@ template <typename S, S (*merge)(S, S), S (*apply)(S, int, int), S (*identity)()
         assert(0 <= u && u < _size);
         assert(0 <= v && v < _size);
         assert(!_dsu.connected(u, v));
-        _tree[u].push_back(v);
-        _tree[v].push_back(u);
+        _edges.emplace_back(u, v);
         _dsu.merge(u, v);
+        _requires_build = true;
     }
 
     // Evaluates and returns a vector of the function at different roots of trees in the forest.
     std::vector<S> evaluate() {
-        std::vector<S> result(_size);
-        for (int i = 0; i < _size; i++) {
-            if (i != _dsu.leader(i)) continue;
-            _dfs_forward(i, -1);
-            _dfs_reverse(i, -1, identity(), result);
+        _build();
+        int n = _size;
+        // `dp[i]` is the product over the subtree at position `i`,
+        // and is replaced by the product from the side of its parent once the parent is visited in the second pass.
+        std::vector<S> dp(n), result(n);
+        for (int i = n - 1; i >= 0; i--) {
+            S acc = identity();
+            for (int c = _child_start[i]; c < _child_start[i + 1]; c++) acc = merge(acc, apply(dp[c], _order[c], _order[i]));
+            dp[i] = acc;
+        }
+
+        // The scratch buffer holds the contribution of each child, then of the parent, followed by the suffix products.
+        std::vector<S> scratch(_max_degree * 2 + 1);
+        for (int i = 0; i < n; i++) {
+            int u = _order[i], p = _parent[i], first = _child_start[i], num_children = _child_start[i + 1] - first;
+            int deg = num_children + (p != -1);
+            S *value = scratch.data(), *suffix = value + deg;
+            for (int j = 0; j < num_children; j++) value[j] = apply(dp[first + j], _order[first + j], u);
+            if (p != -1) value[num_children] = apply(dp[i], p, u);
+            suffix[deg] = identity();
+            for (int j = deg - 1; j >= 0; j--) suffix[j] = merge(value[j], suffix[j + 1]);
+            S prefix = identity();
+            for (int j = 0; j < num_children; j++) {
+                dp[first + j] = merge(prefix, suffix[j + 1]);
+                prefix = merge(prefix, value[j]);
+            }
+            result[u] = suffix[0];
+        }
+        return result;
+    }
+};
+
+// Maintains the same dynamic programming as `rerooting` under changes to the values of nodes and edges,
+// answering at any root in `O(log^2 n)` time per update and per query.
+// Subtrees are represented by `S` as in `rerooting`, and a path cluster `P` represents a subtree with a hole:
+// a node `v` (or a path starting at `v`) together with everything hanging from it except one missing part further away,
+// seen through the edge from `v` to a neighbor `w` that is not in the cluster.
+// Heavy paths of a `heavy_light_decomposition` keep their clusters in a segment tree in both directions,
+// and the light children of each node keep their subtrees in another segment tree,
+// so that an update rebuilds `O(log n)` paths and a query at any root walks up `O(log n)` light edges.
+// Requires the following functions:
+// - `S merge(S dp_l, S dp_r)`
+// - `S identity()`
+// - `P vertex(S dp_children, int v, int w)`: the cluster of `v` with `dp_children` hanging from it, seen from `w`
+// - `P compress(P upper, P lower)`: the cluster of `upper` with `lower` plugged into its hole
+// - `S attach(P path, S dp_hole)`: the subtree of `path` with `dp_hole` plugged into its hole
+//
+// Here `attach(vertex(x, v, w), y)` plays the role of `apply(merge(x, y), v, w)` in `rerooting`.
+// Requires `S` and `P` to be default constructible.
+template <
+    typename S, S (*merge)(S, S), S (*identity)(),
+    typename P, P (*vertex)(S, int, int), P (*compress)(P, P), S (*attach)(P, S)
+> struct dynamic_rerooting {
+  private:
+    int _size = 0, _num_light = 0;
+    heavy_light_decomposition _hld;
+    // `_end[i]` is the end of the heavy path containing position `i`.
+    // The light children `c` of node `v` occupy the slots `_slot[c]` in `[_light_start[v], _light_start[v + 1])`.
+    std::vector<int> _end, _light_start, _slot;
+    // Clusters seen from above and from below, by position in the decomposition order.
+    std::vector<P> _down, _up;
+    std::vector<S> _light;
+    bool _requires_build = false;
+
+    int _heavy(int i) const {
+        return i + 1 < _end[i] ? _hld.node(i + 1) : -1;
+    }
+
+    S _light_prod(int l, int r) const {
+        S result = identity();
+        for (l += _num_light, r += _num_light; l < r; l >>= 1, r >>= 1) {
+            if (l & 1) result = merge(result, _light[l++]);
+            if (r & 1) result = merge(result, _light[--r]);
         }
         return result;
     }
+
+    // Returns the cluster of the positions `[l, r)` seen from above if `!reversed`, else from below.
+    // Requires `l < r`.
+    P _path_prod(int l, int r, bool reversed) const {
+        const std::vector<P> &tree = reversed ? _up : _down;
+        P left, right;
+        bool has_left = false, has_right = false;
+        for (l += _size, r += _size; l < r; l >>= 1, r >>= 1) {
+            if (l & 1) {
+                left = !has_left ? tree[l] : reversed ? compress(tree[l], left) : compress(left, tree[l]);
+                has_left = true;
+                l++;
+            }
+            if (r & 1) {
+                --r;
+                right = !has_right ? tree[r] : reversed ? compress(right, tree[r]) : compress(tree[r], right);
+                has_right = true;
+            }
+        }
+        if (!has_left) return right;
+        if (!has_right) return left;
+        return reversed ? compress(right, left) : compress(left, right);
+    }
+
+    void _pull(int k) {
+        _down[k] = compress(_down[k * 2], _down[k * 2 + 1]);
+        _up[k] = compress(_up[k * 2 + 1], _up[k * 2]);
+    }
+
+    // Returns the subtree hanging below position `i` on its heavy path.
+    S _below(int i) const {
+        return i + 1 < _end[i] ? attach(_path_prod(i + 1, _end[i], false), identity()) : identity();
+    }
+
+    // Sets the clusters of node `v` from the subtrees of its light children.
+    void _set_vertex(int v) {
+        int i = _hld.index(v), p = _hld.parent(v), h = _heavy(i);
+        S dp = _light_prod(_light_start[v], _light_start[v + 1]);
+        // Clusters seen from a missing neighbor are never queried.
+        _down[i + _size] = p == -1 ? P() : vertex(dp, v, p);
+        _up[i + _size] = h == -1 ? P() : vertex(dp, v, h);
+    }
+
+    void _build() {
+        if (!_requires_build) return;
+        _requires_build = false;
+        int n = _size;
+        _hld.build();
+        _end.resize(n);
+        for (int i = n - 1; i >= 0; i--) {
+            _end[i] = i + 1 < n && _hld.head(_hld.node(i + 1)) == _hld.head(_hld.node(i)) ? _end[i + 1] : i + 1;
+        }
+        _light_start.assign(n + 1, 0);
+        _slot.assign(n, -1);
+        for (int v = 0; v < n; v++) {
+            if (_hld.head(v) == v && _hld.parent(v) != -1) _light_start[_hld.parent(v) + 1]++;
+        }
+        for (int v = 0; v < n; v++) _light_start[v + 1] += _light_start[v];
+        _num_light = _light_start[n];
+        std::vector<int> fill(_light_start.begin(), _light_start.end() - 1);
+        for (int v = 0; v < n; v++) {
+            if (_hld.head(v) == v && _hld.parent(v) != -1) _slot[v] = fill[_hld.parent(v)]++;
+        }
+
+        // Light children come after their parents, so each heavy path is complete when its head is reached.
+        _down.assign(n * 2, P());
+        _up.assign(n * 2, P());
+        _light.assign(_num_light * 2, identity());
+        P path;
+        for (int i = n - 1; i >= 0; i--) {
+            int v = _hld.node(i);
+            S dp = identity();
+            for (int k = _light_start[v]; k < _light_start[v + 1]; k++) dp = merge(dp, _light[k + _num_light]);
+            int p = _hld.parent(v), h = _heavy(i);
+            if (p != -1) _down[i + n] = vertex(dp, v, p);
+            if (h != -1) _up[i + n] = vertex(dp, v, h);
+            if (p == -1) continue;
+            path = h == -1 ? _down[i + n] : compress(_down[i + n], path);
+            if (_hld.head(v) == v) _light[_slot[v] + _num_light] = attach(path, identity());
+        }
+        for (int k = n - 1; k >= 1; k--) _pull(k);
+        for (int k = _num_light - 1; k >= 1; k--) _light[k] = merge(_light[k * 2], _light[k * 2 + 1]);
+    }
+
+  public:
+    dynamic_rerooting() {}
+
+    // Constructs a forest with the specified number of disconnected nodes.
+    // Requires `0 <= num_nodes <= 100000000`.
+    dynamic_rerooting(int num_nodes) : _size(num_nodes), _hld(num_nodes), _requires_build(true) {
+        assert(0 <= num_nodes && num_nodes <= 100000000);
+    }
+
+    // Returns the number of nodes in the forest.
+    int size() const {
+        return _size;
+    }
+
+    // Adds an edge between nodes `u` and `v`.
+    // Requires `0 <= u, v < size()`.
+    // Requires `u` and `v` to be formerly disconnected.
+    void add_edge(int u, int v) {
+        assert(0 <= u && u < _size);
+        assert(0 <= v && v < _size);
+        _hld.add_edge(u, v);
+        _requires_build = true;
+    }
+
+    // Recomputes the clusters of node `v` after the results of `vertex(x, v, w)` have changed for some `w`.
+    // After a change to an edge, call this for both of its endpoints.
+    // Requires `0 <= v < size()`.
+    void update(int v) {
+        assert(0 <= v && v < _size);
+        if (_requires_build) return;
+        while (true) {
+            _set_vertex(v);
+            for (int k = (_hld.index(v) + _size) >> 1; k >= 1; k >>= 1) _pull(k);
+            int h = _hld.head(v);
+            v = _hld.parent(h);
+            if (v == -1) break;
+            int k = _slot[h] + _num_light, i = _hld.index(h);
+            _light[k] = attach(_path_prod(i, _end[i], false), identity());
+            for (k >>= 1; k >= 1; k >>= 1) _light[k] = merge(_light[k * 2], _light[k * 2 + 1]);
+        }
+    }
+
+    // Returns the function at the specified root, which equals `rerooting::evaluate()[root]`.
+    // Requires `0 <= root < size()`.
+    S evaluate(int root) {
+        assert(0 <= root && root < _size);
+        _build();
+        // The subtree outside each light edge on the way up is computed from the top down.
+        std::vector<int> chain{root};
+        for (int v = _hld.parent(_hld.head(root)); v != -1; v = _hld.parent(_hld.head(v))) chain.push_back(v);
+        S outside = identity();
+        for (int k = int(chain.size()) - 1; k >= 0; k--) {
+            int v = chain[k], i = _hld.index(v), h = _hld.head(v), hi = _hld.index(h);
+            S dp = merge(_below(i), i == hi ? outside : attach(_path_prod(hi, i, true), outside));
+            if (k == 0) return merge(dp, _light_prod(_light_start[v], _light_start[v + 1]));
+            int c = _hld.head(chain[k - 1]);
+            dp = merge(dp, merge(_light_prod(_light_start[v], _slot[c]), _light_prod(_slot[c] + 1, _light_start[v + 1])));
+            outside = attach(vertex(dp, v, c), identity());
+        }
+        return outside;
+    }
 };
 
 }  // namespace kotone
@@ -0,0 +1,225 @@
+#ifndef KOTONE_ROLLBACK_DSU_HPP
+#define KOTONE_ROLLBACK_DSU_HPP 1
+
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <cassert>
+
+namespace kotone {
+
+// A DSU whose merges can be undone in reverse order.
+// Uses union by size without path compression, so `leader` takes `O(log n)` time and never modifies the forest.
+struct rollback_dsu {
+  private:
+    struct _record {
+        int leader, child, child_size;
+    };
+
+    int _num_components = 0;
+    std::vector<int> _parent_or_size;
+    std::vector<_record> _history;
+
+  public:
+    rollback_dsu() {}
+
+    // Initializes DSU with the specified `num_nodes` and no edges.
+    // Requires `num_nodes >= 0`.
+    rollback_dsu(int num_nodes) : _num_components(num_nodes), _parent_or_size(num_nodes, -1) {
+        assert(num_nodes >= 0);
+    }
+
+    // Returns the number of nodes.
+    int num_nodes() const noexcept {
+        return _parent_or_size.size();
+    }
+
+    // Returns the number of connected components.
+    int num_components() const noexcept {
+        return _num_components;
+    }
+
+    // Returns the leader of the connected component containing `v`.
+    // Requires `0 <= v < num_nodes`.
+    int leader(int v) const {
+        assert(0 <= v && v < num_nodes());
+        while (_parent_or_size[v] >= 0) v = _parent_or_size[v];
+        return v;
+    }
+
+    // Returns whether `u` and `v` belong to the same connected component.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    bool connected(int u, int v) const {
+        return leader(u) == leader(v);
+    }
+
+    // Returns the size of the connected component containing `v`.
+    // Requires `0 <= v < num_nodes`.
+    int size(int v) const {
+        return -_parent_or_size[leader(v)];
+    }
+
+    // Adds an edge between `u` and `v`, then returns the leader of the merged component.
+    // Only merges that join two distinct components are recorded for `rollback`.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    int merge(int u, int v) {
+        u = leader(u);
+        v = leader(v);
+        if (u == v) return u;
+        if (_parent_or_size[u] > _parent_or_size[v]) std::swap(u, v);
+        _history.push_back({u, v, _parent_or_size[v]});
+        _parent_or_size[u] += _parent_or_size[v];
+        _parent_or_size[v] = u;
+        _num_components--;
+        return u;
+    }
+
+    // Returns an identifier of the current state, to be passed to `rollback`.
+    int snapshot() const noexcept {
+        return _history.size();
+    }
+
+    // Undoes every merge made after `snapshot()` returned `state`.
+    // Takes `O(1)` time per undone merge.
+    // Requires `state` to be a snapshot that has not been rolled back past.
+    void rollback(int state) {
+        assert(0 <= state && state <= snapshot());
+        while (int(_history.size()) > state) {
+            auto [u, v, size_v] = _history.back();
+            _history.pop_back();
+            _parent_or_size[v] = size_v;
+            _parent_or_size[u] -= size_v;
+            _num_components++;
+        }
+    }
+};
+
+// An offline solver for connectivity queries on a graph whose edges are added and removed over time.
+// Each edge is alive during an interval of queries, which is inserted into a segment tree over the queries;
+// a depth-first traversal then merges the edges of each segment tree node into a `rollback_dsu`
+// and undoes them on the way back, in `O((m log q + q) log n)` time in total for `m` edges and `q` queries.
+struct offline_dynamic_connectivity {
+  private:
+    int _num_nodes = 0, _num_queries = 0;
+    // Each event is `(min endpoint, max endpoint, sequence number, number of queries so far)`,
+    // where removals store the bitwise complement of their sequence number.
+    std::vector<std::tuple<int, int, int, int>> _events;
+    std::vector<std::pair<int, int>> _queries;
+
+    template <typename F> void _dfs(
+        int k, int l, int r, rollback_dsu &dsu, const std::vector<int> &start, const std::vector<std::pair<int, int>> &edges, F &f
+    ) const {
+        if (l >= _num_queries) return;
+        int state = dsu.snapshot();
+        for (int i = start[k]; i < start[k + 1]; i++) dsu.merge(edges[i].first, edges[i].second);
+        if (r - l == 1) {
+            f(static_cast<const rollback_dsu&>(dsu), l);
+        } else {
+            int m = (l + r) / 2;
+            _dfs(k * 2, l, m, dsu, start, edges, f);
+            _dfs(k * 2 + 1, m, r, dsu, start, edges, f);
+        }
+        dsu.rollback(state);
+    }
+
+  public:
+    offline_dynamic_connectivity() {}
+
+    // Constructs a solver for a graph with the specified number of nodes and no edges.
+    // Requires `num_nodes >= 0`.
+    offline_dynamic_connectivity(int num_nodes) : _num_nodes(num_nodes) {
+        assert(num_nodes >= 0);
+    }
+
+    // Adds an edge between `u` and `v`.
+    // Parallel edges are allowed; each is removed separately.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    void add_edge(int u, int v) {
+        assert(0 <= u && u < _num_nodes);
+        assert(0 <= v && v < _num_nodes);
+        _events.emplace_back(std::min(u, v), std::max(u, v), int(_events.size()), _num_queries);
+    }
+
+    // Removes an edge between `u` and `v`.
+    // Requires an edge between `u` and `v` to be present.
+    void remove_edge(int u, int v) {
+        assert(0 <= u && u < _num_nodes);
+        assert(0 <= v && v < _num_nodes);
+        _events.emplace_back(std::min(u, v), std::max(u, v), ~int(_events.size()), _num_queries);
+    }
+
+    // Records a query on the current graph and returns its index.
+    // `u` and `v` are the nodes that `solve()` tests for connectivity.
+    // Requires `0 <= u < num_nodes`.
+    // Requires `0 <= v < num_nodes`.
+    int add_query(int u, int v) {
+        assert(0 <= u && u < _num_nodes);
+        assert(0 <= v && v < _num_nodes);
+        _queries.emplace_back(u, v);
+        return _num_queries++;
+    }
+
+    // Calls `f(dsu, i)` for each query `i` in increasing order,
+    // where `dsu` is a `const rollback_dsu&` holding exactly the edges alive at that query.
+    template <typename F> void solve(F f) const {
+        // Pairs each removal with the latest unmatched addition of the same edge.
+        std::vector<std::tuple<int, int, int, int>> events = _events;
+        std::sort(events.begin(), events.end(), [](const auto &a, const auto &b) {
+            auto [au, av, as, at] = a;
+            auto [bu, bv, bs, bt] = b;
+            return std::tie(au, av) != std::tie(bu, bv) ? std::tie(au, av) < std::tie(bu, bv)
+                : (as < 0 ? ~as : as) < (bs < 0 ? ~bs : bs);
+        });
+        int size = 1;
+        while (size < _num_queries) size *= 2;
+        std::vector<std::tuple<int, int, int, int>> intervals;
+        std::vector<int> open;
+        for (std::size_t i = 0; i < events.size(); i++) {
+            auto [u, v, seq, time] = events[i];
+            if (seq >= 0) {
+                open.push_back(time);
+            } else {
+                assert(!open.empty());
+                intervals.emplace_back(u, v, open.back(), time);
+                open.pop_back();
+            }
+            if (i + 1 == events.size() || std::get<0>(events[i + 1]) != u || std::get<1>(events[i + 1]) != v) {
+                for (int t : open) intervals.emplace_back(u, v, t, _num_queries);
+                open.clear();
+            }
+        }
+
+        // Segment tree nodes hold their edges in a compressed array.
+        std::vector<int> start(size * 2 + 1);
+        auto for_each_node = [&](int l, int r, auto g) {
+            for (l += size, r += size; l < r; l >>= 1, r >>= 1) {
+                if (l & 1) g(l++);
+                if (r & 1) g(--r);
+            }
+        };
+        for (auto [u, v, l, r] : intervals) for_each_node(l, r, [&](int k) { start[k + 1]++; });
+        for (int k = 0; k < size * 2; k++) start[k + 1] += start[k];
+        std::vector<int> fill(start.begin(), start.end() - 1);
+        std::vector<std::pair<int, int>> edges(start.back());
+        for (auto [u, v, l, r] : intervals) for_each_node(l, r, [&](int k) { edges[fill[k]++] = {u, v}; });
+
+        rollback_dsu dsu(_num_nodes);
+        _dfs(1, 0, size, dsu, start, edges, f);
+    }
+
+    // Returns whether the two nodes of each query were connected at that query.
+    std::vector<bool> solve() const {
+        std::vector<bool> result(_num_queries);
+        solve([&](const rollback_dsu &dsu, int i) {
+            result[i] = dsu.connected(_queries[i].first, _queries[i].second);
+        });
+        return result;
+    }
+};
+
+}  // namespace kotone
+
+#endif  // KOTONE_ROLLBACK_DSU_HPP
@@ -7,6 +7,7 @@
 #include <cassert>
 #include <kotone/random>
 #include <kotone/memory_pool>
+#include <kotone/internal_parallel>
 
 namespace kotone {
 
@@ -28,6 +29,8 @@ template <typename S, S (*op)(S, S), S (*e)()> struct treap_manager {
         int _size = 1;
         bool _rev = false;
 
+        treap(S val, uint64_t priority) : _PRIORITY(priority), _val(val), _prod(val), _prod_rev(val) {}
+
       public:
         // Constructs a treap node with value initialized to `e()`.
         treap() {}
@@ -37,7 +40,11 @@ template <typename S, S (*op)(S, S), S (*e)()> struct treap_manager {
     };
 
   private:
+    static constexpr int _PARALLEL_GRAIN = 1 << 16;
+
     memory_pool<treap> _pool;
+    // Scratch stack for the iterative operations, one per thread so that const operations on disjoint treaps may run concurrently.
+    static inline thread_local std::vector<treap*> _buffer;
 
     void _push(treap *node) const {
         if (!node) return;
@@ -65,11 +72,39 @@ template <typename S, S (*op)(S, S), S (*e)()> struct treap_manager {
         }
     }
 
-    void _init_treap(treap *root) const {
+    // Links `count` nodes created by `make_node(i)` into a treap in O(count) time.
+    template <typename G> treap* _build(int count, G make_node, std::vector<treap*> &stack) const {
+        stack.clear();
+        for (int i = 0; i < count; i++) {
+            treap *node = make_node(i);
+            treap *last = nullptr;
+            while (stack.size() && stack.back()->_PRIORITY < node->_PRIORITY) {
+                last = stack.back();
+                stack.pop_back();
+                _update(last);
+            }
+            node->_left = last;
+            if (stack.size()) stack.back()->_right = node;
+            stack.push_back(node);
+        }
+        while (stack.size() > 1) {
+            _update(stack.back());
+            stack.pop_back();
+        }
+        _update(stack[0]);
+        return stack[0];
+    }
+
+    void _to_vector_parallel(treap *root, S *out, int depth) const {
         if (!root) return;
-        _init_treap(root->_left);
-        _init_treap(root->_right);
-        _update(root);
+        _push(root);
+        int left_size = size(root->_left);
+        out[left_size] = root->_val;
+        fork_join(
+            depth > 0 && size(root) >= _PARALLEL_GRAIN,
+            [&] { _to_vector_parallel(root->_left, out, depth - 1); },
+            [&] { _to_vector_parallel(root->_right, out + left_size + 1, depth - 1); }
+        );
     }
 
     void _to_vector(treap *root, std::vector<S> &vec) const {
@@ -129,30 +164,42 @@ template <typename S, S (*op)(S, S), S (*e)()> struct treap_manager {
     // If `vec` is empty, returns `nullptr`.
     treap* allocate_treap(const std::vector<S> &vec) {
         if (vec.empty()) return nullptr;
-        std::vector<treap*> stack;
+        _pool.reserve(vec.size());
+        return _build(vec.size(), [&](int i) { return _pool.allocate(vec[i]); }, _buffer);
+    }
+
+    // Converts the vector to a treap using multiple threads and returns a pointer to the root of the treap.
+    // If `vec` is empty, returns `nullptr`.
+    treap* allocate_treap_parallel(const std::vector<S> &vec) {
+        if (vec.empty()) return nullptr;
+        int n = vec.size(), blocks = parallel_blocks(n, _PARALLEL_GRAIN);
+        treap *nodes = _pool.allocate_uninitialized(n);
+        std::vector<uint64_t> seeds(blocks);
+        for (uint64_t &seed : seeds) seed = randint();
+        std::vector<treap*> roots(blocks);
+        parallel_for(n, _PARALLEL_GRAIN, [&](int b, int64_t l, int64_t r) {
+            std::vector<treap*> stack;
+            roots[b] = _build(r - l, [&](int i) {
+                return new (nodes + l + i) treap(vec[l + i], splitmix64(seeds[b] + i));
+            }, stack);
+        });
         treap *root = nullptr;
-        for (S val : vec) {
-            treap *node = _pool.allocate(val);
-            treap *last = nullptr;
-            while (stack.size() && stack.back()->_PRIORITY < node->_PRIORITY) {
-                last = stack.back();
-                stack.pop_back();
-            }
-            node->_left = last;
-            if (stack.size()) stack.back()->_right = node;
-            else root = node;
-            stack.push_back(node);
-        }
-        _init_treap(root);
+        for (treap *block_root : roots) root = merge(root, block_root);
         return root;
     }
 
     // Frees all memory allocated to nodes in the treap and invalidates their pointers.
     void deallocate_treap(treap *root) {
         if (!root) return;
-        deallocate_treap(root->_left);
-        deallocate_treap(root->_right);
-        _pool.deallocate(root);
+        std::vector<treap*> &stack = _buffer;
+        stack.assign(1, root);
+        while (stack.size()) {
+            treap *node = stack.back();
+            stack.pop_back();
+            if (node->_left) stack.push_back(node->_left);
+            if (node->_right) stack.push_back(node->_right);
+            _pool.deallocate(node);
+        }
     }
 
     // Returns the size of the treap.
@@ -169,24 +216,39 @@ template <typename S, S (*op)(S, S), S (*e)()> struct treap_manager {
         return result;
     }
 
+    // Returns a vector containing the values of the treap, using multiple threads for large treaps.
+    std::vector<S> to_vector_parallel(treap *root) const {
+        std::vector<S> result(size(root), e());
+        _to_vector_parallel(root, result.data(), fork_depth());
+        return result;
+    }
+
     // Merges `root_l` and `root_r`, then returns a pointer to the root of the new treap.
     // This method invalidates `root_l` and `root_r`.
     // Requires `root_l` and `root_r` to be disconnected.
     treap* merge(treap *root_l, treap *root_r) const {
         assert(!root_l || !root_r || root_l != root_r);
-        _push(root_l);
-        _push(root_r);
-        treap *result;
-        if (!root_l || !root_r) {
-            result = root_l ? root_l : root_r;
-        } else if (root_l->_PRIORITY >= root_r->_PRIORITY) {
-            root_l->_right = merge(root_l->_right, root_r);
-            result = root_l;
-        } else {
-            root_r->_left = merge(root_l, root_r->_left);
-            result = root_r;
+        std::vector<treap*> &path = _buffer;
+        path.clear();
+        treap *result = nullptr, **slot = &result;
+        while (root_l && root_r) {
+            if (root_l->_PRIORITY >= root_r->_PRIORITY) {
+                _push(root_l);
+                path.push_back(*slot = root_l);
+                slot = &root_l->_right;
+                root_l = root_l->_right;
+            } else {
+                _push(root_r);
+                path.push_back(*slot = root_r);
+                slot = &root_r->_left;
+                root_r = root_r->_left;
+            }
+        }
+        *slot = root_l ? root_l : root_r;
+        while (path.size()) {
+            _update(path.back());
+            path.pop_back();
         }
-        _update(result);
         return result;
     }
 
@@ -197,20 +259,30 @@ template <typename S, S (*op)(S, S), S (*e)()> struct treap_manager {
     // Requires `0 <= index <= size(root)`.
     std::pair<treap*, treap*> split(treap *root, int index) const {
         assert(0 <= index && index <= size(root));
-        if (!root) return {nullptr, nullptr};
-        _push(root);
-        int left_size = size(root->_left);
-        if (index <= left_size) {
-            auto [l, r] = split(root->_left, index);
-            root->_left = r;
-            _update(root);
-            return {l, root};
-        } else {
-            auto [l, r] = split(root->_right, index - left_size - 1);
-            root->_right = l;
-            _update(root);
-            return {root, r};
+        std::vector<treap*> &path = _buffer;
+        path.clear();
+        treap *root_l = nullptr, *root_r = nullptr, **slot_l = &root_l, **slot_r = &root_r;
+        while (root) {
+            _push(root);
+            path.push_back(root);
+            int left_size = size(root->_left);
+            if (index <= left_size) {
+                *slot_r = root;
+                slot_r = &root->_left;
+                root = root->_left;
+            } else {
+                *slot_l = root;
+                slot_l = &root->_right;
+                root = root->_right;
+                index -= left_size + 1;
+            }
+        }
+        *slot_l = *slot_r = nullptr;
+        while (path.size()) {
+            _update(path.back());
+            path.pop_back();
         }
+        return {root_l, root_r};
     }
 
     // Returns the product of the treap.
@@ -221,6 +293,18 @@ template <typename S, S (*op)(S, S), S (*e)()> struct treap_manager {
         return e();
     }
 
+    // Returns the product of the concatenation of the treaps, using multiple threads for many treaps.
+    // Requires the treaps to be pairwise disconnected.
+    S get_prod_parallel(const std::vector<treap*> &roots) const {
+        std::vector<S> prods(parallel_blocks(roots.size(), _PARALLEL_GRAIN), e());
+        parallel_for(roots.size(), _PARALLEL_GRAIN, [&](int b, int64_t l, int64_t r) {
+            for (int64_t i = l; i < r; i++) prods[b] = op(prods[b], get_prod(roots[i]));
+        });
+        S result = e();
+        for (const S &prod : prods) result = op(result, prod);
+        return result;
+    }
+
     // Returns the product of the interval `[l, r)` in the treap.
     // Requires `0 <= l <= r <= size(root)`.
     S get_prod(treap *&root, int l, int r) const {
@@ -254,6 +338,7 @@ template <typename S, S (*op)(S, S), S (*e)()> struct treap_manager {
         auto [nl, nml] = split(root, index);
         auto [nmr, nr] = split(nml, 1);
         nmr->_val = val;
+        _update(nmr);
         root = merge(merge(nl, nmr), nr);
     }
 
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <random>
+#include <numbers>
+#include <cmath>
+#include <cassert>
+#include <kotone/convolution_real>
+
+using C = std::complex<double>;
+
+std::vector<double> naive_convolution(const std::vector<double> &a, const std::vector<double> &b) {
+    if (a.empty() || b.empty()) return {};
+    std::vector<double> result(a.size() + b.size() - 1);
+    for (std::size_t i = 0; i < a.size(); i++) {
+        for (std::size_t j = 0; j < b.size(); j++) result[i + j] += a[i] * b[j];
+    }
+    return result;
+}
+
+bool close(const std::vector<double> &a, const std::vector<double> &b, double eps = 1e-8) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); i++) if (std::abs(a[i] - b[i]) > eps) return false;
+    return true;
+}
+
+int main() {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> dist(-1, 1);
+    auto random_vector = [&](int n) {
+        std::vector<double> vec(n);
+        for (double &x : vec) x = dist(rng);
+        return vec;
+    };
+
+    // Convolution against the naive product, including lengths 1 and 2 and odd lengths
+    assert(kotone::convolution(std::vector<double>{}, random_vector(3)).empty());
+    for (int len_l = 1; len_l <= 20; len_l++) {
+        for (int len_r = 1; len_r <= 20; len_r++) {
+            auto a = random_vector(len_l), b = random_vector(len_r);
+            assert(close(kotone::convolution(a, b), naive_convolution(a, b)));
+        }
+    }
+    for (int iter = 0; iter < 50; iter++) {
+        auto a = random_vector(rng() % 700 + 1), b = random_vector(rng() % 700 + 1);
+        assert(close(kotone::convolution(a, b), naive_convolution(a, b), 1e-7));
+    }
+
+    // A plan reused across sizes, with integer inputs rounding back exactly
+    kotone::fft_plan<double> plan(1 << 10);
+    for (int len : {1, 2, 3, 5, 64, 333, 512}) {
+        std::vector<double> a(len), b(len + 1);
+        for (double &x : a) x = rng() % 1000;
+        for (double &x : b) x = rng() % 1000;
+        std::vector<double> result = plan.convolution(a, b), expected = naive_convolution(a, b);
+        assert(result.size() == expected.size());
+        for (std::size_t i = 0; i < result.size(); i++) assert(std::llround(result[i]) == std::llround(expected[i]));
+    }
+
+    // The natural-order transform against the naive discrete Fourier transform, and back
+    for (int n = 1; n <= 256; n *= 2) {
+        std::vector<C> fps(n), expected(n, 0);
+        for (C &c : fps) c = {dist(rng), dist(rng)};
+        for (int k = 0; k < n; k++) {
+            for (int j = 0; j < n; j++) expected[k] += fps[j] * std::polar(1.0, 2 * std::numbers::pi * j * k / n);
+        }
+        std::vector<C> transformed = fps;
+        kotone::fast_fourier_transform(transformed, false);
+        for (int k = 0; k < n; k++) assert(std::abs(transformed[k] - expected[k]) < 1e-9);
+        kotone::fast_fourier_transform(transformed, true);
+        for (int k = 0; k < n; k++) assert(std::abs(transformed[k] - fps[k]) < 1e-9);
+    }
+
+    // The thread-local plan grows on demand and is shared afterwards
+    kotone::fft_plan<double> &shared = kotone::shared_fft_plan<double>(1 << 12);
+    assert(shared.size() >= 1 << 12);
+    assert(&kotone::shared_fft_plan<double>(4) == &shared);
+
+    // The row and column split of large transforms is bit-identical to the serial transforms
+    kotone::fft_plan<double> large(1 << 17);
+    for (int n : {1 << 16, 1 << 17}) {
+        std::vector<C> serial(n);
+        for (C &c : serial) c = {dist(rng), dist(rng)};
+        std::vector<C> parallel = serial;
+        large.forward(serial);
+        large.forward(parallel, true);
+        assert(serial == parallel);
+        large.inverse(serial);
+        large.inverse(parallel, true);
+        assert(serial == parallel);
+    }
+    auto a = random_vector(50000), b = random_vector(40001);
+    std::vector<double> result = kotone::convolution(a, b, true);
+    assert(result == kotone::convolution(a, b));
+    for (int i : {0, 1, 12345, 50000, 89999}) {
+        double expected = 0;
+        for (int j = std::max(0, i - 40000); j <= std::min(i, 49999); j++) expected += a[j] * b[i - j];
+        assert(std::abs(result[i] - expected) < 1e-6);
+    }
+    std::clog << "OK" << std::endl;
+}
@@ -0,0 +1,35 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <kotone/convolution_util>
+
+using mint = atcoder::modint998244353;
+
+int main() {
+    std::mt19937 rng(0);
+    for (int iter = 0; iter < 100; iter++) {
+        std::vector<mint> num(rng() % 40 + 1), denom(rng() % 20 + 1);
+        for (mint &c : num) c = rng();
+        for (mint &c : denom) c = rng();
+        denom[0] = rng() % 4 + 1;
+
+        // Compares against the power series expansion of `num / denom`
+        int len = 500;
+        std::vector<mint> series = kotone::naive_convolution(num, kotone::inv_fps(denom, len));
+        std::vector<int64_t> ks(30);
+        for (int64_t &k : ks) k = rng() % len;
+        std::vector<mint> batch = kotone::bostan_mori(num, denom, ks);
+        for (int i = 0; i < 30; i++) {
+            assert(batch[i] == series[ks[i]]);
+            assert(kotone::bostan_mori(num, denom, ks[i]) == series[ks[i]]);
+        }
+    }
+
+    // Fibonacci numbers
+    std::vector<int64_t> ks{0, 1, 2, 10, 90, 1000000000000000000};
+    std::vector<mint> fib = kotone::solve_recurrence<mint>({1, 1}, {0, 1}, ks);
+    assert(fib[3] == 55);
+    for (int i = 0; i < int(ks.size()); i++) assert(fib[i] == kotone::solve_recurrence<mint>({1, 1}, {0, 1}, ks[i]));
+
+    std::clog << "OK" << std::endl;
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <kotone/dsu>
+
+int main() {
+    std::mt19937 rng(1);
+
+    // Potentials survive deep paths and path compression
+    for (int iter = 0; iter < 100; iter++) {
+        int n = rng() % 100 + 1;
+        kotone::dsu<int64_t> d(n);
+        std::vector<int> comp(n);
+        std::vector<int64_t> potential(n);
+        for (int i = 0; i < n; i++) comp[i] = i, potential[i] = rng() % 1000;
+        for (int q = 0; q < 200; q++) {
+            int u = rng() % n, v = rng() % n;
+            if (rng() % 2) {
+                int64_t pd = potential[v] - potential[u];
+                bool joined = comp[u] != comp[v];
+                int cu = comp[u], cv = comp[v];
+                int64_t shift = potential[u] + (rng() % 100) - potential[v];
+                if (joined) {
+                    for (int i = 0; i < n; i++) {
+                        if (comp[i] == cv) comp[i] = cu, potential[i] += shift;
+                    }
+                    pd = potential[v] - potential[u];
+                }
+                d.merge(u, v, pd);
+            }
+            assert(d.connected(u, v) == (comp[u] == comp[v]));
+            if (comp[u] == comp[v]) assert(d.potential_diff(u, v) == potential[v] - potential[u]);
+        }
+    }
+
+    // Batches match one merge at a time
+    int n = 200000;
+    std::vector<std::pair<int, int>> edges(n * 3 / 4);
+    for (auto &[u, v] : edges) u = rng() % n, v = rng() % n;
+    kotone::dsu serial(n), batched(n);
+    int merged = 0;
+    for (auto [u, v] : edges) merged += !serial.connected(u, v), serial.merge(u, v);
+    assert(batched.merge_batch(edges) == merged);
+    auto expected = serial.components();
+    std::sort(expected.begin(), expected.end());
+    auto result = batched.components();
+    std::sort(result.begin(), result.end());
+    assert(result == expected);
+
+    // Concurrent union-find
+    kotone::concurrent_dsu concurrent(n);
+    assert(concurrent.merge_batch(edges) == merged);
+    result = concurrent.components();
+    std::sort(result.begin(), result.end());
+    assert(result == expected);
+    for (int q = 0; q < 1000; q++) {
+        int u = rng() % n, v = rng() % n;
+        assert(concurrent.connected(u, v) == serial.connected(u, v));
+    }
+
+    // Threads calling `merge` and `connected` directly, regardless of the number of cores
+    kotone::concurrent_dsu shared(n);
+    std::vector<int> final_leader(n);
+    for (int v = 0; v < n; v++) final_leader[v] = serial.leader(v);
+    std::atomic<int> shared_merged = 0;
+    std::atomic<bool> consistent = true;
+    std::vector<std::thread> threads;
+    int num_threads = 8;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 local_rng(t);
+            for (std::size_t i = t; i < edges.size(); i += num_threads) {
+                shared_merged += shared.merge(edges[i].first, edges[i].second);
+                // Nodes connected at any time are connected in the final graph.
+                int u = local_rng() % n, v = local_rng() % n;
+                if (shared.connected(u, v) && final_leader[u] != final_leader[v]) consistent = false;
+                if (!shared.connected(edges[i].first, edges[i].second)) consistent = false;
+            }
+        });
+    }
+    for (std::thread &thread : threads) thread.join();
+    assert(consistent);
+    assert(shared_merged == merged);
+    result = shared.components();
+    std::sort(result.begin(), result.end());
+    assert(result == expected);
+
+    // Labels from `leaders()` partition the nodes as the serial leaders do
+    std::vector<int> labels = shared.leaders(), serial_of(n, -1);
+    int num_labels = 0;
+    for (int v = 0; v < n; v++) {
+        assert(labels[labels[v]] == labels[v]);
+        if (serial_of[labels[v]] == -1) serial_of[labels[v]] = final_leader[v], num_labels++;
+        assert(serial_of[labels[v]] == final_leader[v]);
+    }
+    assert(num_labels == int(expected.size()));
+
+    // Threads calling `leader` on a deep chain, where path splitting races on the same nodes
+    int chain_length = 100000;
+    kotone::concurrent_dsu chain(chain_length);
+    for (int v = 0; v + 1 < chain_length; v++) chain.merge(v, v + 1);
+    std::atomic<int> wrong_leaders = 0;
+    threads.clear();
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < chain_length; i++) {
+                int v = (i * 7 + t * 12345) % chain_length;
+                if (chain.leader(v) != chain_length - 1) wrong_leaders++;
+            }
+        });
+    }
+    for (std::thread &thread : threads) thread.join();
+    assert(wrong_leaders == 0);
+
+    std::clog << "OK" << std::endl;
+}
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <kotone/fenwick_tree>
+
+int main() {
+    std::mt19937 rng(7);
+    const int H = 13, W = 29;
+    std::vector<std::vector<int64_t>> matrix(H, std::vector<int64_t>(W));
+    std::vector<std::pair<int64_t, int64_t>> points;
+    for (int i = 0; i < H; i++) {
+        for (int j = 0; j < W; j++) {
+            matrix[i][j] = rng() % 10;
+            if (rng() % 3 == 0) points.emplace_back(i * 1000, j * 1000);
+        }
+    }
+
+    kotone::fenwick_tree_2d<int64_t> sparse(H, W), dense(H, W, true), built(matrix);
+    kotone::static_fenwick_tree_2d<int64_t> offline(points);
+    std::vector<std::vector<int64_t>> offline_matrix(H, std::vector<int64_t>(W));
+    for (int i = 0; i < H; i++) {
+        for (int j = 0; j < W; j++) {
+            sparse.add(i, j, matrix[i][j]);
+            dense.add(i, j, matrix[i][j]);
+        }
+    }
+    assert(!sparse.is_dense() && dense.is_dense() && built.is_dense());
+
+    for (int q = 0; q < 3000; q++) {
+        if (q % 2 == 0) {
+            int i = rng() % H, j = rng() % W, val = rng() % 10;
+            matrix[i][j] += val;
+            sparse.add(i, j, val);
+            dense.add(i, j, val);
+            built.add(i, j, val);
+            auto [x, y] = points[rng() % points.size()];
+            offline_matrix[x / 1000][y / 1000] += val;
+            offline.add(x, y, val);
+        }
+        int li = rng() % (H + 1), ri = rng() % (H + 1), lj = rng() % (W + 1), rj = rng() % (W + 1);
+        if (li > ri) std::swap(li, ri);
+        if (lj > rj) std::swap(lj, rj);
+        int64_t expected = 0, offline_expected = 0;
+        for (int i = li; i < ri; i++) {
+            for (int j = lj; j < rj; j++) {
+                expected += matrix[i][j];
+                offline_expected += offline_matrix[i][j];
+            }
+        }
+        assert(sparse.sum(li, lj, ri, rj) == expected);
+        assert(dense.sum(li, lj, ri, rj) == expected);
+        assert(built.sum(li, lj, ri, rj) == expected);
+        assert(offline.sum(li * 1000 - 1, lj * 1000 - 1, ri * 1000 - 1, rj * 1000 - 1) == offline_expected);
+        if (li == 0 && lj == 0) assert(dense.sum(ri, rj) == expected);
+    }
+    std::clog << "OK" << std::endl;
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <kotone/fenwick_tree>
+
+int main() {
+    std::mt19937 rng(42);
+    const int N = 300;
+    std::vector<int64_t> vec(N);
+    for (int64_t &v : vec) v = rng() % 10;
+
+    kotone::fenwick_tree<int64_t> sparse(N), dense(N, true), built(vec);
+    kotone::range_fenwick_tree<int64_t> range_sparse(N), range_built(vec);
+    for (int i = 0; i < N; i++) {
+        sparse.add(i, vec[i]);
+        dense.add(i, vec[i]);
+        range_sparse.add(i, vec[i]);
+    }
+    assert(!sparse.is_dense() && dense.is_dense() && built.is_dense());
+
+    // `vec` also receives the range additions, which only the range trees see.
+    std::vector<int64_t> points = vec;
+
+    for (int q = 0; q < 2000; q++) {
+        int l = rng() % (N + 1), r = rng() % (N + 1);
+        if (l > r) std::swap(l, r);
+        if (q % 3 == 0) {
+            int pos = rng() % N, val = rng() % 10;
+            vec[pos] += val;
+            points[pos] += val;
+            sparse.add(pos, val);
+            dense.add(pos, val);
+            built.add(pos, val);
+            range_sparse.add(pos, val);
+            range_built.add(pos, val);
+        } else if (q % 3 == 1) {
+            int val = rng() % 10;
+            for (int i = l; i < r; i++) vec[i] += val;
+            range_sparse.add(l, r, val);
+            range_built.add(l, r, val);
+        }
+        int64_t expected = 0;
+        for (int i = l; i < r; i++) expected += vec[i];
+        assert(range_sparse.sum(l, r) == expected);
+        assert(range_built.sum(l, r) == expected);
+        int64_t expected_points = 0;
+        for (int i = l; i < r; i++) expected_points += points[i];
+        assert(sparse.sum(l, r) == expected_points);
+        assert(dense.sum(l, r) == expected_points);
+        assert(built.sum(l, r) == expected_points);
+    }
+
+    // Binary search over prefix sums
+    std::vector<int64_t> point(N);
+    kotone::fenwick_tree<int64_t> counts(N), dense_counts(N, true);
+    for (int i = 0; i < N; i++) {
+        point[i] = rng() % 3;
+        counts.add(i, point[i]);
+        dense_counts.add(i, point[i]);
+    }
+    int64_t total = counts.sum(0, N);
+    for (int64_t val = 0; val <= total + 1; val++) {
+        int64_t expected = 0, acc = 0;
+        while (acc < val && expected < N) acc += point[expected++];
+        if (acc < val) expected = N + 1;
+        assert(counts.lower_bound(val) == expected);
+        assert(dense_counts.lower_bound(val) == expected);
+    }
+    for (int l = 0; l <= N; l += 7) {
+        int64_t expected = 0;
+        for (int r = l; r <= N; r++) {
+            assert(sparse.sum(l, r) == expected && dense.sum(l, r) == expected && built.sum(l, r) == expected);
+            if (r < N) expected += points[r];
+        }
+    }
+    std::clog << "OK" << std::endl;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <kotone/heavy_light_decomposition>
+#include <kotone/segment_tree>
+#include <kotone/fenwick_tree>
+
+// Concatenation of node labels, to check the order of path products
+using S = std::vector<int>;
+S op(S a, S b) {
+    a.insert(a.end(), b.begin(), b.end());
+    return a;
+}
+S e() { return {}; }
+
+int main() {
+    std::mt19937 rng(1);
+    for (int iter = 0; iter < 100; iter++) {
+        int n = rng() % 200 + 1;
+        kotone::heavy_light_decomposition hld(n);
+        std::vector<std::vector<int>> children(n);
+        for (int i = 1; i < n; i++) {
+            int p = rng() % i;
+            children[p].push_back(i);
+            if (rng() % 2) hld.add_edge(p, i);
+            else hld.add_edge(i, p);
+        }
+        hld.build();
+        std::vector<int> parent(n, -1), depth(n), label(n);
+        for (int u = 0; u < n; u++) {
+            for (int v : children[u]) parent[v] = u, depth[v] = depth[u] + 1;
+        }
+        for (int v = 0; v < n; v++) {
+            assert(hld.parent(v) == parent[v] && hld.depth(v) == depth[v]);
+            assert(hld.node(hld.index(v)) == v);
+            label[v] = v * 2;
+        }
+        assert(hld.reorder(label)[hld.index(n - 1)] == (n - 1) * 2);
+
+        // Subtrees are contiguous
+        for (int v = 0; v < n; v++) {
+            auto [l, r] = hld.subtree(v);
+            for (int i = l; i < r; i++) {
+                int x = hld.node(i);
+                while (x != v && x != -1) x = parent[x];
+                assert(x == v);
+            }
+        }
+
+        kotone::segment_tree<S, op, e> seg(n), seg_rev(n);
+        for (int v = 0; v < n; v++) {
+            seg.set(hld.index(v), {v});
+            seg_rev.set(n - 1 - hld.index(v), {v});
+        }
+        kotone::range_fenwick_tree<int64_t> fenwick(n, true);
+        std::vector<int64_t> added(n);
+        for (int q = 0; q < 100; q++) {
+            int u = rng() % n, v = rng() % n;
+            S up, down;
+            int a = u, b = v;
+            while (a != b) {
+                if (depth[a] >= depth[b]) up.push_back(a), a = parent[a];
+                else down.push_back(b), b = parent[b];
+            }
+            S path = up;
+            path.push_back(a);
+            path.insert(path.end(), down.rbegin(), down.rend());
+            assert(hld.lca(u, v) == a);
+            assert(hld.distance(u, v) == int(path.size()) - 1);
+
+            // Path products in order, with and without the LCA
+            auto prod = [&](int l, int r) { return seg.prod(l, r); };
+            auto prod_rev = [&](int l, int r) { return seg_rev.prod(n - r, n - l); };
+            assert((hld.path_prod<S, op, e>(u, v, prod, prod_rev)) == path);
+            S edges = path;
+            edges.erase(std::find(edges.begin(), edges.end(), a));
+            assert((hld.path_prod<S, op, e>(u, v, prod, prod_rev, true)) == edges);
+
+            // Path updates with subtree queries
+            hld.path_apply(u, v, [&](int l, int r) { fenwick.add(l, r, q); });
+            for (int x : path) added[x] += q;
+            int w = rng() % n;
+            auto [l, r] = hld.subtree(w);
+            int64_t expected = 0;
+            for (int i = l; i < r; i++) expected += added[hld.node(i)];
+            assert(fenwick.sum(l, r) == expected);
+        }
+    }
+
+    // Deep paths and forests
+    int n = 1000000;
+    kotone::heavy_light_decomposition path(n + 1);
+    for (int i = 1; i < n; i++) path.add_edge(i - 1, i);
+    path.build(n - 1);
+    assert(path.depth(0) == n - 1);
+    assert(path.lca(0, n / 2) == n / 2);
+    assert(path.lca(0, n) == -1);
+    assert(path.subtree(n - 1) == std::make_pair(0, n));
+
+    std::clog << "OK" << std::endl;
+}
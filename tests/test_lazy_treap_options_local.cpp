@@ -0,0 +1,50 @@
+#include <iostream>
+#include <vector>
+#include <kotone/lazy_treap>
+
+using S = std::pair<int64_t, int64_t>;
+S op(S a, S b) { return {a.first + b.first, a.second + b.second}; }
+S e() { return {0, 0}; }
+using F = int64_t;
+S mapping(F f, S x) { return {x.first + f * x.second, x.second}; }
+F composition(F f, F g) { return f + g; }
+F id() { return 0; }
+
+template <int options> void check_sums() {
+    kotone::lazy_treap_manager<S, op, e, F, mapping, composition, id, options> treap;
+    std::vector<S> vec(10);
+    std::vector<int64_t> result(10);
+    for (int i = 0; i < 10; i++) vec[i] = {result[i] = i * i, 1};
+    auto root = treap.allocate_treap(vec);
+    treap.insert(root, treap.allocate_node({7, 1}), 4);
+    result.insert(result.begin() + 4, 7);
+    treap.set_val(root, 9, {-3, 1});
+    result[9] = -3;
+    if constexpr (!(options & kotone::LAZY_TREAP_NO_LAZY)) {
+        treap.apply(root, 5, 2, 8);
+        for (int i = 2; i < 8; i++) result[i] += 5;
+    }
+    if constexpr (!(options & kotone::LAZY_TREAP_NO_REVERSE)) {
+        treap.reverse(root, 1, 10);
+        std::reverse(result.begin() + 1, result.begin() + 10);
+    }
+    for (int l = 0; l <= 11; l++) {
+        int64_t sum = 0;
+        for (int r = l; r <= 11; r++) {
+            assert(treap.get_prod(root, l, r).first == sum);
+            if (r < 11) sum += result[r];
+        }
+    }
+    auto values = treap.to_vector(root);
+    for (int i = 0; i < 11; i++) assert(values[i].first == result[i]);
+    treap.deallocate_treap(root);
+    std::clog << "options " << options << ": " << sizeof(*root) << " bytes per node" << std::endl;
+}
+
+int main() {
+    check_sums<0>();
+    check_sums<kotone::LAZY_TREAP_NO_REVERSE>();
+    check_sums<kotone::LAZY_TREAP_NO_LAZY>();
+    check_sums<kotone::LAZY_TREAP_HASHED_PRIORITY>();
+    check_sums<kotone::LAZY_TREAP_NO_REVERSE | kotone::LAZY_TREAP_NO_LAZY | kotone::LAZY_TREAP_HASHED_PRIORITY>();
+}
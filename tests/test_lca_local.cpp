@@ -0,0 +1,74 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <kotone/lca>
+
+int main() {
+    std::mt19937 rng(1);
+
+    // Random forests against walking up parents
+    for (int iter = 0; iter < 200; iter++) {
+        int n = rng() % 300 + 1;
+        kotone::lca_tree tree(n);
+        std::vector<int> parent(n, -1), depth(n);
+        for (int i = 1; i < n; i++) {
+            if (rng() % 10 == 0) continue;
+            parent[i] = rng() % i;
+            depth[i] = depth[parent[i]] + 1;
+            tree.add_edge(parent[i], i);
+        }
+        std::vector<std::pair<int, int>> queries;
+        std::vector<int> expected_batch;
+        for (int q = 0; q < 300; q++) {
+            int u = rng() % n, v = rng() % n, a = u, b = v;
+            while (a != b && a != -1 && b != -1) {
+                if (depth[a] < depth[b]) std::swap(a, b);
+                a = parent[a];
+            }
+            int expected = a == b ? a : -1;
+            assert(tree.get_lca(u, v) == expected);
+            assert(tree.get_distance(u, v) == (expected == -1 ? -1 : depth[u] + depth[v] - depth[expected] * 2));
+            queries.emplace_back(u, v);
+            expected_batch.push_back(expected);
+
+            // Level ancestors and jumps along the path
+            int k = rng() % (depth[u] + 2), x = u;
+            for (int i = 0; i < k && x != -1; i++) x = parent[x];
+            assert(tree.level_ancestor(u, k) == x);
+            if (expected == -1) {
+                assert(tree.jump(u, v, 0) == -1);
+                continue;
+            }
+            std::vector<int> path;
+            for (int x = u; x != expected; x = parent[x]) path.push_back(x);
+            int turn = path.size();
+            for (int x = v; x != expected; x = parent[x]) path.push_back(x);
+            path.insert(path.begin() + turn, expected);
+            std::reverse(path.begin() + turn + 1, path.end());
+            for (int k = 0; k <= int(path.size()); k++) assert(tree.jump(u, v, k) == (k < int(path.size()) ? path[k] : -1));
+        }
+        assert(tree.get_lca_batch(queries) == expected_batch);
+    }
+
+    // A path of a million nodes does not overflow the stack
+    int n = 1000000;
+    kotone::lca_tree path(n);
+    for (int i = 1; i < n; i++) path.add_edge(i - 1, i);
+    assert(path.get_lca(n - 1, n / 2) == n / 2);
+    assert(path.get_distance(0, n - 1) == n - 1);
+    assert(path.level_ancestor(n - 1, n - 1) == 0);
+    assert(path.jump(0, n - 1, n / 3) == n / 3);
+    std::vector<std::pair<int, int>> queries{{n - 1, 5}, {3, 3}, {n / 2, n / 4}};
+    assert(path.get_lca_batch(queries) == std::vector<int>({5, 3, n / 4}));
+
+    // Undirected trees still report distances
+    kotone::lca_tree undirected(5);
+    undirected.add_edge(0, 1);
+    undirected.add_edge(2, 1);
+    undirected.add_edge(3, 2);
+    assert(undirected.get_distance(0, 3) == 3);
+    assert(undirected.get_lca(0, 4) == -1);
+
+    std::clog << "OK" << std::endl;
+}
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <kotone/link_cut_tree>
+
+// Affine maps composed along the path, to check the order of products
+using affine = std::pair<int64_t, int64_t>;
+constexpr int64_t MOD = 998244353;
+affine op_affine(affine f, affine g) { return {f.first * g.first % MOD, (g.first * f.second + g.second) % MOD}; }
+affine e_affine() { return {1, 0}; }
+int no_map() { return 0; }
+affine map_affine(int, affine x) { return x; }
+int compose(int, int) { return 0; }
+
+// Sums with path additions
+using sum_size = std::pair<int64_t, int64_t>;
+sum_size op_sum(sum_size a, sum_size b) { return {a.first + b.first, a.second + b.second}; }
+sum_size e_sum() { return {0, 0}; }
+sum_size map_add(int64_t f, sum_size x) { return {x.first + f * x.second, x.second}; }
+int64_t compose_add(int64_t f, int64_t g) { return f + g; }
+int64_t id_add() { return 0; }
+
+int main() {
+    std::mt19937 rng(1);
+    for (int iter = 0; iter < 50; iter++) {
+        int n = rng() % 30 + 1;
+        std::vector<affine> value(n);
+        std::vector<sum_size> init(n);
+        std::vector<int64_t> weight(n);
+        for (int v = 0; v < n; v++) {
+            value[v] = {rng() % MOD, rng() % MOD};
+            weight[v] = rng() % 100;
+            init[v] = {weight[v], 1};
+        }
+        kotone::lazy_link_cut_tree<affine, op_affine, e_affine, int, map_affine, compose, no_map> composite(value);
+        kotone::lazy_link_cut_tree<sum_size, op_sum, e_sum, int64_t, map_add, compose_add, id_add> sums(init);
+
+        std::vector<std::vector<int>> adj(n);
+        auto parents_from = [&](int s) {
+            std::vector<int> parent(n, -2), stack{s};
+            parent[s] = -1;
+            while (!stack.empty()) {
+                int u = stack.back();
+                stack.pop_back();
+                for (int x : adj[u]) if (parent[x] == -2) parent[x] = u, stack.push_back(x);
+            }
+            return parent;
+        };
+
+        for (int q = 0; q < 300; q++) {
+            int type = rng() % 5, u = rng() % n, v = rng() % n;
+            std::vector<int> parent = parents_from(u);
+            if (type == 0 && parent[v] == -2) {
+                composite.reorient(u);
+                composite.link(u, v);
+                sums.reorient(u);
+                sums.link_batch(std::vector<std::pair<int, int>>{{u, v}});
+                adj[u].push_back(v);
+                adj[v].push_back(u);
+            } else if (type == 1 && parent[v] >= 0) {
+                int p = parent[v];
+                composite.reorient(u);
+                composite.cut(v);
+                sums.reorient(u);
+                sums.cut_batch(std::vector<int>{v});
+                std::erase(adj[v], p);
+                std::erase(adj[p], v);
+            } else if (type == 2) {
+                value[u] = {rng() % MOD, rng() % MOD};
+                composite.set(u, value[u]);
+            } else if (type == 3 && parent[v] != -2) {
+                int64_t f = rng() % 10;
+                sums.apply(u, v, f);
+                for (int x = v; x != -1; x = parent[x]) weight[x] += f;
+            } else if (parent[v] != -2) {
+                std::vector<int> path;
+                for (int x = v; x != -1; x = parent[x]) path.push_back(x);
+                affine expected = e_affine();
+                int64_t sum = 0;
+                for (int i = int(path.size()) - 1; i >= 0; i--) {
+                    expected = op_affine(expected, value[path[i]]);
+                    sum += weight[path[i]];
+                }
+                assert(composite.prod(u, v) == expected);
+                assert(composite.prod(v, u) == [&] {
+                    affine result = e_affine();
+                    for (int x : path) result = op_affine(result, value[x]);
+                    return result;
+                }());
+                assert(sums.prod(u, v) == sum_size(sum, path.size()));
+                assert(sums.get(v).first == weight[v]);
+                sums.reorient(u);
+                assert(sums.depth(v) == int(path.size()) - 1);
+                assert(sums.level_ancestor(v, 0) == u && sums.lca(u, v) == u);
+            }
+        }
+    }
+    std::clog << "OK" << std::endl;
+}
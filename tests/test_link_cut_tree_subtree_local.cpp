@@ -0,0 +1,102 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <kotone/link_cut_tree>
+
+// `acc` covers splay subtrees with their virtual children, `path` only the splay subtrees
+std::vector<int64_t> weight, acc, virt, path;
+void on_update(int p, int l, int r) {
+    acc[p] = weight[p] + virt[p];
+    path[p] = weight[p];
+    if (l != -1) acc[p] += acc[l], path[p] += path[l];
+    if (r != -1) acc[p] += acc[r], path[p] += path[r];
+}
+void on_virtual(int p, int c, bool attach) {
+    virt[p] += attach ? acc[c] : -acc[c];
+}
+
+int main() {
+    std::mt19937 rng(1);
+    for (int iter = 0; iter < 50; iter++) {
+        int n = rng() % 30 + 1;
+        weight.assign(n, 0);
+        for (int64_t &w : weight) w = rng() % 100;
+        acc = path = weight;
+        virt.assign(n, 0);
+        kotone::link_cut_tree<on_update, nullptr, nullptr, on_virtual> lct(n);
+
+        // Naive forest as undirected adjacency
+        std::vector<std::vector<int>> adj(n);
+        auto parents_from = [&](int s) {
+            std::vector<int> parent(n, -2), stack{s};
+            parent[s] = -1;
+            while (!stack.empty()) {
+                int u = stack.back();
+                stack.pop_back();
+                for (int x : adj[u]) if (parent[x] == -2) parent[x] = u, stack.push_back(x);
+            }
+            return parent;
+        };
+
+        // Initial edges in one batch, each linking a fresh root
+        std::vector<std::pair<int, int>> edges;
+        for (int v = 1; v < n; v++) {
+            if (rng() % 3 == 0) continue;
+            int p = rng() % v;
+            edges.emplace_back(v, p);
+            adj[v].push_back(p);
+            adj[p].push_back(v);
+        }
+        lct.link_batch(edges);
+
+        for (int q = 0; q < 300; q++) {
+            int type = rng() % 4, u = rng() % n, v = rng() % n;
+            std::vector<int> parent = parents_from(u);
+            if (type == 0 && parent[v] == -2) {
+                // Link
+                lct.reorient(u);
+                lct.link(u, v);
+                adj[u].push_back(v);
+                adj[v].push_back(u);
+            } else if (type == 1 && parent[v] >= 0) {
+                // Cut the edge between `v` and its neighbor towards `u`
+                int p = parent[v];
+                lct.reorient(u);
+                std::vector<int> cuts{v};
+                lct.cut_batch(cuts);
+                std::erase(adj[v], p);
+                std::erase(adj[p], v);
+            } else if (type == 2) {
+                // Point update
+                lct.access(u);
+                weight[u] += v;
+                lct.update(u);
+            } else {
+                // Subtree of `v` rooted at `u`, the whole tree, and the `u`-`v` path
+                if (parent[v] == -2) continue;
+                int64_t expected = 0, total = 0;
+                for (int x = 0; x < n; x++) total += parent[x] != -2 ? weight[x] : 0;
+                std::vector<int> stack{v};
+                std::vector<bool> seen(n);
+                seen[v] = true;
+                if (parent[v] >= 0) seen[parent[v]] = true;
+                while (!stack.empty()) {
+                    int x = stack.back();
+                    stack.pop_back();
+                    expected += weight[x];
+                    for (int y : adj[x]) if (!seen[y]) seen[y] = true, stack.push_back(y);
+                }
+                lct.reorient(u);
+                lct.access(v);
+                assert(weight[v] + virt[v] == expected);
+                int64_t path_sum = 0, depth = -1;
+                for (int x = v; x != -1; x = parent[x]) path_sum += weight[x], depth++;
+                assert(path[v] == path_sum);
+                assert(acc[v] == total);
+                assert(lct.depth(v) == depth);
+                assert(lct.level_ancestor(v, depth) == v && lct.level_ancestor(v, 0) == u);
+            }
+        }
+    }
+    std::clog << "OK" << std::endl;
+}
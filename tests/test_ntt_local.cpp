@@ -0,0 +1,103 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <atcoder/modint>
+#include <kotone/ntt>
+
+using mint = atcoder::modint998244353;
+
+std::vector<mint> naive(const std::vector<mint> &a, const std::vector<mint> &b) {
+    std::vector<mint> result(a.size() + b.size() - 1);
+    for (unsigned i = 0; i < a.size(); i++) {
+        for (unsigned j = 0; j < b.size(); j++) result[i + j] += a[i] * b[j];
+    }
+    return result;
+}
+
+int main() {
+    std::mt19937 rng(0);
+    kotone::ntt_plan<mint> plan(1 << 10);
+
+    // Forward and inverse transforms of every supported length round-trip
+    for (int n = 1; n <= plan.size(); n *= 2) {
+        std::vector<mint> vec(n);
+        for (mint &c : vec) c = rng();
+        std::vector<mint> copy = vec;
+        plan.forward(copy);
+        plan.inverse(copy);
+        assert(copy == vec);
+    }
+
+    // Convolutions through the plan and through the shared plan agree with the naive product
+    for (int iter = 0; iter < 100; iter++) {
+        std::vector<mint> a(rng() % 300 + 1), b(rng() % 200 + 1);
+        for (mint &c : a) c = rng();
+        for (mint &c : b) c = rng();
+        std::vector<mint> expected = naive(a, b);
+        assert(plan.convolution(a, b) == expected);
+        assert(kotone::ntt_convolution(a, b) == expected);
+    }
+
+    // Lopsided products are split into blocks, and Karatsuba handles every leaf size
+    for (int iter = 0; iter < 20; iter++) {
+        std::vector<mint> a(rng() % 100 + 65), b(rng() % 5000 + 1000);
+        for (mint &c : a) c = rng();
+        for (mint &c : b) c = rng();
+        std::vector<mint> expected = naive(a, b), result(expected.size());
+        assert(kotone::ntt_convolution(a, b) == expected);
+        kotone::karatsuba_convolution<mint>(a, b, result, iter % 4 + 1);
+        assert(result == expected);
+    }
+
+    // Transforms can be reused across products
+    std::vector<mint> a{1, 2, 3, 0, 0, 0, 0, 0}, b{4, 5, 0, 0, 0, 0, 0, 0};
+    plan.forward(a);
+    plan.forward(b);
+    plan.multiply(a, b);
+    plan.multiply(a, b);
+    plan.inverse(a);
+    assert(a == std::vector<mint>({16, 72, 153, 170, 75, 0, 0, 0}));
+
+    // Parallel transforms agree with serial ones
+    {
+        kotone::ntt_plan<mint> large(1 << 17);
+        std::vector<mint> a(1 << 17), b;
+        for (mint &c : a) c = rng();
+        b = a;
+        large.forward(a);
+        large.forward(std::span<mint>(b), true);
+        assert(a == b);
+        large.inverse(std::span<mint>(b), true);
+        large.inverse(a);
+        assert(a == b);
+        std::vector<mint> l(70000), r(50000);
+        for (mint &c : l) c = rng();
+        for (mint &c : r) c = rng();
+        assert(kotone::ntt_convolution(l, r, true) == kotone::ntt_convolution(l, r));
+    }
+
+    // Moduli that are not NTT-friendly go through three primes and the Chinese remainder theorem
+    using mint_arbitrary = atcoder::modint1000000007;
+    for (int iter = 0; iter < 20; iter++) {
+        std::vector<mint_arbitrary> a(rng() % 300 + 1, mint_arbitrary::mod() - 1), b(rng() % 200 + 1);
+        for (mint_arbitrary &c : b) c = rng();
+        std::vector<mint_arbitrary> expected(a.size() + b.size() - 1);
+        for (unsigned i = 0; i < a.size(); i++) {
+            for (unsigned j = 0; j < b.size(); j++) expected[i + j] += a[i] * b[j];
+        }
+        assert(kotone::ntt_convolution(a, b) == expected);
+    }
+
+    // A shared plan is rebuilt for a new modulus at only the length it supports
+    using mint_dynamic = atcoder::dynamic_modint<1>;
+    mint_dynamic::set_mod(998244353);
+    std::vector<mint_dynamic> long_l(1 << 14, 1), long_r(1 << 14, 1);
+    assert(kotone::shared_ntt_plan<mint_dynamic>(1 << 15).convolution(long_l, long_r)[(1 << 14) - 1] == 1 << 14);
+    mint_dynamic::set_mod(7681);
+    std::vector<mint_dynamic> short_l(100, 1), short_r(100, 1);
+    std::vector<mint_dynamic> short_result = kotone::shared_ntt_plan<mint_dynamic>(256).convolution(short_l, short_r);
+    assert(short_result[99] == 100);
+    assert(kotone::ntt_convolution(short_l, short_r) == short_result);
+
+    std::clog << "OK" << std::endl;
+}
@@ -0,0 +1,45 @@
+#include <iostream>
+#include <vector>
+#include <tuple>
+#include <random>
+#include <kotone/partially_persistent_dsu>
+#include <kotone/dsu>
+
+int main() {
+    std::mt19937 rng(1);
+    for (int iter = 0; iter < 50; iter++) {
+        int n = rng() % 50 + 1, m = rng() % 100;
+        kotone::partially_persistent_dsu pdsu(n);
+        std::vector<std::pair<int, int>> edges(m);
+        for (auto &[u, v] : edges) {
+            u = rng() % n, v = rng() % n;
+            auto [l, t] = pdsu.add_edge(u, v);
+            assert(l == pdsu.leader(u, t) && l == pdsu.leader(v, t));
+        }
+        assert(pdsu.version() == m);
+
+        // Replays the edges to compare every version
+        kotone::dsu<int> d(n);
+        std::vector<std::tuple<int, int, int>> queries;
+        std::vector<bool> expected;
+        for (int t = 0; t <= m; t++) {
+            if (t) d.merge(edges[t - 1].first, edges[t - 1].second);
+            for (int v = 0; v < n; v++) {
+                assert(pdsu.size(v, t) == d.size(v));
+                int u = rng() % n;
+                assert(pdsu.connected(u, v, t) == d.connected(u, v));
+                queries.emplace_back(u, v, t);
+                expected.push_back(d.connected(u, v));
+            }
+        }
+        assert(pdsu.connected(queries) == expected);
+    }
+
+    // A single component growing one node at a time keeps long size histories
+    int n = 100000;
+    kotone::partially_persistent_dsu chain(n);
+    for (int i = 1; i < n; i++) chain.add_edge(0, i);
+    for (int t = 0; t < n; t += 997) assert(chain.size(n - 1, t) == 1 + (t >= n - 1) * (n - 1) && chain.size(0, t) == t + 1);
+
+    std::clog << "OK" << std::endl;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <kotone/persistent_treap>
+#include <kotone/persistent_lazy_treap>
+
+using S = std::vector<int>;
+S op(S a, S b) {
+    a.insert(a.end(), b.begin(), b.end());
+    return a;
+}
+S e() { return {}; }
+
+int64_t op_sum(int64_t a, int64_t b) { return a + b; }
+int64_t e_sum() { return 0; }
+int64_t mapping(int64_t f, int64_t x) { return f * x; }
+int64_t composition(int64_t f, int64_t g) { return f * g; }
+int64_t id() { return 1; }
+
+int main() {
+    {
+    // Construction
+    std::vector<S> vec(8);
+    for (int i = 0; i < 8; i++) vec[i] = {i};
+    kotone::persistent_treap_manager<S, op, e> treap;
+    auto v0 = treap.allocate_treap(vec);
+    assert(treap.size(v0) == 8);
+    S result = treap.get_prod(v0);
+
+    // Old versions remain valid after updates
+    auto v1 = treap.reverse(v0, 2, 6);
+    auto v2 = treap.set_val(v1, 0, {99});
+    assert(treap.get_prod(v0) == result);
+    assert(treap.get_prod(v1) == S({0, 1, 5, 4, 3, 2, 6, 7}));
+    assert(treap.get_prod(v2) == S({99, 1, 5, 4, 3, 2, 6, 7}));
+    assert(treap.get_prod(v2, 1, 4) == S({1, 5, 4}));
+    assert(treap.get_val(v1, 2)[0] == 5);
+
+    // Self-concatenation shares nodes
+    auto v3 = treap.merge(v1, v1);
+    assert(treap.size(v3) == 16);
+    auto v4 = treap.reverse(v3);
+    S doubled = treap.get_prod(v1), copy = doubled;
+    doubled.insert(doubled.end(), copy.begin(), copy.end());
+    assert(treap.get_prod(v3) == doubled);
+    std::reverse(doubled.begin(), doubled.end());
+    assert(treap.get_prod(v4) == doubled);
+    assert(treap.get_prod(v1) == S({0, 1, 5, 4, 3, 2, 6, 7}));
+
+    // Split, slice, insert and remove
+    auto [l, r] = treap.split(v2, 3);
+    assert(treap.get_prod(l) == S({99, 1, 5}));
+    assert(treap.get_prod(r) == S({4, 3, 2, 6, 7}));
+    auto sliced = treap.slice(v4, 0, 2);
+    auto v5 = treap.insert(v0, sliced, 8);
+    assert(treap.get_prod(v5) == S({0, 1, 2, 3, 4, 5, 6, 7, 7, 6}));
+    auto v6 = treap.remove(v5, 1, 9);
+    assert(treap.get_prod(v6) == S({0, 6}));
+    assert(treap.to_vector(v5).size() == 10u);
+
+    // Binary search
+    auto short_prefix = [](const S &vec) { return vec.size() <= 3u; };
+    assert(treap.max_right(v1, 2, short_prefix) == 5);
+    assert(treap.min_left(v1, 8, short_prefix) == 5);
+
+    for (auto root : {v0, v1, v2, v3, v4, v5, v6, l, r, sliced}) treap.deallocate_treap(root);
+    }
+
+    {
+    // Lazy propagation on shared nodes
+    kotone::persistent_lazy_treap_manager<int64_t, op_sum, e_sum, int64_t, mapping, composition, id> treap;
+    auto v0 = treap.allocate_treap({1, 2, 3, 4, 5});
+    auto v1 = treap.apply(v0, 10, 1, 4);
+    auto v2 = treap.merge(v1, v0);
+    auto v3 = treap.apply(v2, 2);
+    assert(treap.to_vector(v0) == std::vector<int64_t>({1, 2, 3, 4, 5}));
+    assert(treap.to_vector(v1) == std::vector<int64_t>({1, 20, 30, 40, 5}));
+    assert(treap.get_prod(v2) == 111);
+    assert(treap.get_prod(v3, 3, 7) == 2 * (40 + 5 + 1 + 2));
+    auto v4 = treap.reverse(v3, 0, 6);
+    assert(treap.to_vector(v4) == std::vector<int64_t>({2, 10, 80, 60, 40, 2, 4, 6, 8, 10}));
+    assert(treap.to_vector(v3) == std::vector<int64_t>({2, 40, 60, 80, 10, 2, 4, 6, 8, 10}));
+    for (auto root : {v0, v1, v2, v3, v4}) treap.deallocate_treap(root);
+    }
+
+    std::clog << "OK" << std::endl;
+}
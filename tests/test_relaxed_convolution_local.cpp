@@ -0,0 +1,38 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <atcoder/modint>
+#include <kotone/relaxed_convolution>
+#include <kotone/convolution_util>
+
+using mint = atcoder::modint998244353;
+
+int main() {
+    // Matches the offline product coefficient by coefficient
+    std::mt19937 rng(0);
+    for (int len : {1, 2, 3, 31, 64, 65, 200, 1000}) {
+        std::vector<mint> f(len), g(len);
+        for (mint &c : f) c = rng();
+        for (mint &c : g) c = rng();
+        std::vector<mint> expected = kotone::naive_convolution(f, g);
+        kotone::relaxed_convolution<mint> conv;
+        for (int i = 0; i < len; i++) assert(conv.push(f[i], g[i]) == expected[i]);
+        assert(conv.size() == len);
+    }
+
+    // Online use: `f = 1 + x f^2` generates the Catalan numbers
+    int len = 3000;
+    kotone::relaxed_convolution<mint> conv;
+    std::vector<mint> catalan{1};
+    for (int i = 0; i + 1 < len; i++) {
+        mint sq = conv.push(catalan[i], catalan[i]);
+        catalan.push_back(sq);
+    }
+    mint c = 1;
+    for (int i = 0; i < len; i++) {
+        assert(catalan[i] == c);
+        c = c * (4 * i + 2) / (i + 2);
+    }
+
+    std::clog << "OK" << std::endl;
+}
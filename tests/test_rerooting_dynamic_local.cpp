@@ -0,0 +1,120 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cassert>
+#include <kotone/rerooting>
+
+// The farthest other node by edge weight plus its own value, where `merge` is a maximum with no inverse.
+using S = long long;
+const S NONE = -(1LL << 60);
+
+std::vector<long long> A, W;
+std::vector<int> parent;
+long long weight(int u, int v) {
+    return W[parent[u] == v ? u : v];
+}
+
+S merge(S l, S r) {
+    return std::max(l, r);
+}
+
+S apply(S dp, int child, int parent) {
+    return std::max(dp, A[child]) + weight(child, parent);
+}
+
+S identity() {
+    return NONE;
+}
+
+// A subtree with a hole maps the hole `h` to `max(h + dist, best)`; composing two of these is not commutative.
+struct P {
+    long long dist, best;
+};
+
+P vertex(S dp, int v, int w) {
+    long long d = weight(v, w);
+    return {d, std::max(dp, A[v]) + d};
+}
+
+P compress(P upper, P lower) {
+    return {upper.dist + lower.dist, std::max(upper.best, lower.best + upper.dist)};
+}
+
+S attach(P path, S hole) {
+    return std::max(hole + path.dist, path.best);
+}
+
+int main() {
+    std::mt19937 rng(1);
+
+    // Random forests against `rerooting` after each change
+    for (int iter = 0; iter < 300; iter++) {
+        int n = rng() % 60 + 1;
+        A.resize(n);
+        W.resize(n);
+        parent.assign(n, -1);
+        for (auto &a : A) a = int(rng() % 200) - 100;
+        for (auto &w : W) w = rng() % 10 + 1;
+        std::vector<int> label(n);
+        for (int i = 0; i < n; i++) label[i] = i;
+        std::shuffle(label.begin(), label.end(), rng);
+        kotone::rerooting<S, merge, apply, identity> expected(n);
+        kotone::dynamic_rerooting<S, merge, identity, P, vertex, compress, attach> tree(n);
+        int shape = rng() % 3;
+        for (int i = 1; i < n; i++) {
+            if (rng() % 8 == 0) continue;
+            int j = shape == 0 ? i - 1 : shape == 1 ? rng() % i : std::max(0, i - 1 - int(rng() % 3));
+            parent[label[i]] = label[j];
+            expected.add_edge(label[i], label[j]);
+            tree.add_edge(label[i], label[j]);
+        }
+        for (int q = 0; q < 50; q++) {
+            std::vector<S> result = expected.evaluate();
+            for (int k = 0; k < 3; k++) {
+                int r = rng() % n;
+                assert(tree.evaluate(r) == result[r]);
+            }
+            int v = rng() % n;
+            if (rng() % 2) {
+                A[v] = int(rng() % 200) - 100;
+                tree.update(v);
+            } else if (parent[v] != -1) {
+                W[v] = rng() % 10 + 1;
+                tree.update(v);
+                tree.update(parent[v]);
+            }
+        }
+    }
+
+    // A path of a million nodes answers at both ends after changes in the middle
+    int n = 1000000;
+    A.assign(n, 0);
+    W.assign(n, 1);
+    parent.assign(n, -1);
+    kotone::dynamic_rerooting<S, merge, identity, P, vertex, compress, attach> path(n);
+    for (int i = 1; i < n; i++) {
+        parent[i] = i - 1;
+        path.add_edge(i - 1, i);
+    }
+    assert(path.evaluate(0) == n - 1);
+    A[n / 2] = n;
+    path.update(n / 2);
+    W[n - 1] = n;
+    path.update(n - 1);
+    path.update(n - 2);
+    S from_first = NONE, from_last = NONE;
+    long long dist = 0;
+    for (int i = 1; i < n; i++) {
+        dist += W[i];
+        from_first = std::max(from_first, dist + A[i]);
+    }
+    dist = 0;
+    for (int i = n - 2; i >= 0; i--) {
+        dist += W[i + 1];
+        from_last = std::max(from_last, dist + A[i]);
+    }
+    assert(path.evaluate(0) == from_first);
+    assert(path.evaluate(n - 1) == from_last);
+    std::clog << "OK" << std::endl;
+}
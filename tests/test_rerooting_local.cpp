@@ -0,0 +1,82 @@
+#include <iostream>
+#include <vector>
+#include <utility>
+#include <random>
+#include <cassert>
+#include <kotone/rerooting>
+
+// The weighted sum of distances to all other nodes, weighted by node values.
+using S = std::pair<long long, long long>;
+
+std::vector<long long> A;
+long long weight(int u, int v) {
+    return (u + v) % 7 + 1;
+}
+
+S merge(S l, S r) {
+    return {l.first + r.first, l.second + r.second};
+}
+
+S apply(S dp, int child, int parent) {
+    return {dp.first + weight(child, parent) * (dp.second + A[child]), dp.second + A[child]};
+}
+
+S identity() {
+    return {0, 0};
+}
+
+int main() {
+    std::mt19937 rng(1);
+
+    // Random forests against a search from every root
+    for (int iter = 0; iter < 200; iter++) {
+        int n = rng() % 100 + 1;
+        A.resize(n);
+        for (auto &a : A) a = rng() % 100;
+        kotone::rerooting<S, merge, apply, identity> tree(n);
+        std::vector<std::vector<int>> adjacent(n);
+        std::vector<int> order(n);
+        for (int i = 0; i < n; i++) order[i] = i;
+        std::shuffle(order.begin(), order.end(), rng);
+        for (int round = 0; round < 2; round++) {
+            for (int i = 1; i < n; i++) {
+                if (rng() % 4 || !adjacent[order[i]].empty()) continue;
+                int u = order[i], v = order[rng() % i];
+                if (adjacent[v].size() && rng() % 2 == 0) continue;
+                // Joining a node without edges keeps the forest acyclic.
+                tree.add_edge(u, v);
+                adjacent[u].push_back(v);
+                adjacent[v].push_back(u);
+            }
+            std::vector<S> result = tree.evaluate();
+            for (int r = 0; r < n; r++) {
+                long long expected = 0;
+                std::vector<long long> dist(n, -1);
+                std::vector<int> queue{r};
+                dist[r] = 0;
+                for (std::size_t k = 0; k < queue.size(); k++) {
+                    int u = queue[k];
+                    expected += dist[u] * A[u];
+                    for (int v : adjacent[u]) {
+                        if (dist[v] != -1) continue;
+                        dist[v] = dist[u] + weight(u, v);
+                        queue.push_back(v);
+                    }
+                }
+                assert(result[r].first == expected);
+            }
+        }
+    }
+
+    // A path of a million nodes does not overflow the stack
+    int n = 1000000;
+    A.assign(n, 1);
+    kotone::rerooting<S, merge, apply, identity> path(n);
+    for (int i = 1; i < n; i++) path.add_edge(i - 1, i);
+    std::vector<S> result = path.evaluate();
+    long long expected = 0;
+    for (int i = 1; i < n; i++) expected += weight(i - 1, i) * (long long)(n - i);
+    assert(result[0].first == expected);
+    assert(result[n - 1].second == n - 1);
+    std::clog << "OK" << std::endl;
+}
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <kotone/rollback_dsu>
+#include <kotone/dsu>
+
+int main() {
+    std::mt19937 rng(1);
+
+    // Rollback restores earlier states exactly
+    {
+        kotone::rollback_dsu dsu(6);
+        dsu.merge(0, 1);
+        int state = dsu.snapshot();
+        dsu.merge(2, 3);
+        dsu.merge(1, 3);
+        dsu.merge(0, 2);
+        assert(dsu.connected(0, 3) && dsu.size(2) == 4 && dsu.num_components() == 3);
+        dsu.rollback(state);
+        assert(dsu.connected(0, 1) && !dsu.connected(1, 2) && !dsu.connected(2, 3));
+        assert(dsu.size(0) == 2 && dsu.size(3) == 1 && dsu.num_components() == 5);
+        dsu.rollback(0);
+        assert(!dsu.connected(0, 1) && dsu.num_components() == 6);
+    }
+
+    // Offline dynamic connectivity against rebuilding after every event
+    for (int iter = 0; iter < 100; iter++) {
+        int n = rng() % 10 + 1;
+        kotone::offline_dynamic_connectivity solver(n);
+        std::vector<std::pair<int, int>> alive;
+        std::vector<bool> expected;
+        std::vector<int> components;
+        for (int e = 0; e < 100; e++) {
+            int type = rng() % 3, u = rng() % n, v = rng() % n;
+            if (type == 0) {
+                solver.add_edge(u, v);
+                alive.emplace_back(u, v);
+            } else if (type == 1 && !alive.empty()) {
+                int i = rng() % alive.size();
+                auto [a, b] = alive[i];
+                if (rng() % 2) std::swap(a, b);
+                solver.remove_edge(a, b);
+                alive.erase(alive.begin() + i);
+            } else {
+                kotone::dsu<int> dsu(n);
+                for (auto [a, b] : alive) dsu.merge(a, b);
+                assert(solver.add_query(u, v) == int(expected.size()));
+                expected.push_back(dsu.connected(u, v));
+                components.push_back(dsu.components().size());
+            }
+        }
+        assert(solver.solve() == expected);
+        solver.solve([&](const kotone::rollback_dsu &dsu, int i) { assert(dsu.num_components() == components[i]); });
+    }
+
+    std::clog << "OK" << std::endl;
+}
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <thread>
 #include <kotone/treap>
 
 using S = std::vector<int>;
@@ -124,6 +125,23 @@ int main() {
     std::clog << std::endl;
     }
 
+    {
+    // Parallel construction and export
+    std::vector<S> large_vec(200000);
+    for (int i = 0; i < 200000; i++) large_vec[i] = {i % 7};
+    auto large_root = treap.allocate_treap_parallel(large_vec);
+    assert(treap.size(large_root) == 200000);
+    treap.reverse(large_root, 100, 150000);
+    std::reverse(large_vec.begin() + 100, large_vec.begin() + 150000);
+    assert(treap.to_vector_parallel(large_root) == large_vec);
+    assert(treap.to_vector(large_root) == large_vec);
+    std::vector<decltype(large_root)> roots{root, large_root};
+    S prod = treap.get_prod_parallel(roots);
+    assert(prod.size() == 200015u);
+    assert(S(prod.begin(), prod.begin() + 15) == result);
+    treap.deallocate_treap(large_root);
+    }
+
     {
     // Binary search: max_right
     auto has_no_negative = [](const S &vec) {
@@ -175,4 +193,25 @@ int main() {
     for (int r: result) std::clog << r << ' ';
     std::clog << std::endl;
     }
+
+    // Concurrent split and merge on disjoint roots of one manager, each thread using its own scratch buffer
+    {
+        std::vector<decltype(treap)::treap*> roots(4);
+        for (auto &root : roots) root = treap.allocate_treap(vec);
+        std::vector<std::thread> threads;
+        for (auto &root : roots) threads.emplace_back([&treap, &root] {
+            for (int i = 0; i < 1000; i++) {
+                auto [l, r] = treap.split(root, i % 17);
+                root = treap.merge(r, l);
+            }
+        });
+        for (auto &thread : threads) thread.join();
+        S expected(16);
+        for (int i = 0; i < 16; i++) expected[i] = i;
+        for (int i = 0; i < 1000; i++) std::rotate(expected.begin(), expected.begin() + i % 17, expected.end());
+        for (auto root : roots) {
+            assert(treap.get_prod(root) == expected);
+            treap.deallocate_treap(root);
+        }
+    }
 }